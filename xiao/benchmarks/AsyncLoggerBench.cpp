@@ -0,0 +1,174 @@
+/**
+ * @file   AsyncLoggerBench.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// AsyncFileLogger with per-thread staging buffers against the logger it
+// replaced, where every line is appended to a shared buffer under one mutex,
+// from 1 to 64 logging threads. The time is the time the logging threads
+// spend in output(), the writer catches up after it.
+
+#include "Benchmark.h"
+#include <xiao/utils/AsyncFileLogger.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+
+BEGIN_NAMESPACE(xiao)
+
+static const uint64_t xLines = 1000 * 1000;
+
+// The shared buffer logger, the way AsyncFileLogger was before the
+// per-thread buffers.
+class MutexFileLogger
+{
+public:
+	explicit MutexFileLogger(const std::string& fileName)
+		: fp_(fopen(fileName.c_str(), "w")),
+		buffer_(new std::string),
+		thread_([this]() { writeLogs(); })
+	{
+		buffer_->reserve(xBufferSize);
+	}
+	~MutexFileLogger()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cond_.notify_one();
+		thread_.join();
+		fclose(fp_);
+	}
+	void output(const char* msg, size_t len)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (buffer_->capacity() - buffer_->length() < len)
+		{
+			buffers_.push_back(std::move(buffer_));
+			buffer_.reset(new std::string);
+			buffer_->reserve(xBufferSize);
+			cond_.notify_one();
+		}
+		buffer_->append(msg, len);
+	}
+
+private:
+	static const size_t xBufferSize = 4 * 1024 * 1024;
+
+	void writeLogs()
+	{
+		std::deque<std::unique_ptr<std::string>> buffers;
+		bool stop = false;
+		while (!stop)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cond_.wait(lock, [this]() { return stop_ || !buffers_.empty(); });
+				stop = stop_;
+				if (stop && !buffer_->empty())
+					buffers_.push_back(std::move(buffer_));
+				buffers.swap(buffers_);
+			}
+			for (auto& buf : buffers)
+				fwrite(buf->data(), 1, buf->length(), fp_);
+			buffers.clear();
+		}
+		fflush(fp_);
+	}
+
+	FILE* fp_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::unique_ptr<std::string> buffer_;
+	std::deque<std::unique_ptr<std::string>> buffers_;
+	bool stop_{ false };
+	std::thread thread_;
+};
+
+// A log line of about 100 bytes.
+static size_t formatLine(char* buf, size_t size, size_t thread, uint64_t n)
+{
+	return snprintf(buf,
+		size,
+		"20261017 12:00:00.000000 %zu INFO the benchmark log line number %llu "
+		"- AsyncLoggerBench.cpp:42\n",
+		thread,
+		static_cast<unsigned long long>(n));
+}
+
+template <typename LoggerType>
+static double runLogger(size_t threads, std::unique_ptr<LoggerType> logger)
+{
+	auto linesPerThread = xLines / threads;
+	return runThreads(threads, [&](size_t i) {
+		char line[160];
+		for (uint64_t n = 0; n < linesPerThread; ++n)
+		{
+			auto len = formatLine(line, sizeof(line), i, n);
+			logger->output(line, len);
+		}
+	});
+}
+
+// Remove the log files, AsyncFileLogger renames its file when it's closed.
+static void removeLogs(const std::string& path)
+{
+	auto dir = opendir(path.c_str());
+	if (!dir)
+		return;
+	while (auto entry = readdir(dir))
+	{
+		if (entry->d_name[0] != '.')
+			unlink((path + entry->d_name).c_str());
+	}
+	closedir(dir);
+}
+
+void benchAsyncLogger()
+{
+	char dir[] = "/tmp/xiao_bench_XXXXXX";
+	if (!mkdtemp(dir))
+	{
+		perror("mkdtemp");
+		return;
+	}
+	std::string path = std::string(dir) + "/";
+	for (auto threads : xBenchThreadCounts)
+	{
+		auto ops = xLines / threads * threads;
+
+		std::unique_ptr<AsyncFileLogger> logger(new AsyncFileLogger);
+		logger->setFileName("async", ".log", path);
+		logger->setFileSizeLimit(UINT64_MAX);
+		// don't drop lines, block until the writer catches up
+		logger->setBackpressurePolicy(AsyncFileLogger::xBlockWithTimeout);
+		logger->setBlockTimeout(std::chrono::milliseconds(60 * 1000));
+		logger->startLogging();
+		printResult("AsyncFileLogger, per-thread buffers",
+			threads,
+			ops,
+			runLogger(threads, std::move(logger)));
+		removeLogs(path);
+
+		std::unique_ptr<MutexFileLogger> baseline(
+			new MutexFileLogger(path + "mutex.log"));
+		printResult("AsyncFileLogger, shared buffer",
+			threads,
+			ops,
+			runLogger(threads, std::move(baseline)));
+		removeLogs(path);
+	}
+	rmdir(dir);
+}
+
+END_NAMESPACE(xiao)
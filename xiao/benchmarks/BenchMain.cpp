@@ -0,0 +1,59 @@
+/**
+ * @file   BenchMain.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// xiao_bench runs the benchmarks of the library, built with
+// -DBUILD_BENCHMARKS=ON.
+//
+// usage: xiao_bench [name...]
+//   runs the named benchmarks, all of them by default
+
+#include "Benchmark.h"
+#include <string.h>
+
+using namespace xiao;
+
+struct BenchmarkEntry
+{
+	const char* name_;
+	void (*func_)();
+};
+
+static const BenchmarkEntry xBenchmarks[] = {
+	{ "mpsc_queue", benchMpscQueue },
+	{ "task_queue", benchTaskQueue },
+	{ "timing_wheel", benchTimingWheel },
+	{ "async_logger", benchAsyncLogger },
+	{ "log_format", benchLogFormat },
+};
+
+int main(int argc, char* argv[])
+{
+	bool found = argc == 1;
+	for (auto& benchmark : xBenchmarks)
+	{
+		bool selected = argc == 1;
+		for (int i = 1; i < argc; ++i)
+		{
+			if (strcmp(argv[i], benchmark.name_) == 0)
+				selected = true;
+		}
+		if (!selected)
+			continue;
+		found = true;
+		printf("== %s\n", benchmark.name_);
+		benchmark.func_();
+	}
+	if (!found)
+	{
+		fprintf(stderr, "usage: %s [name...], the names are:\n", argv[0]);
+		for (auto& benchmark : xBenchmarks)
+			fprintf(stderr, "  %s\n", benchmark.name_);
+		return 1;
+	}
+	return 0;
+}
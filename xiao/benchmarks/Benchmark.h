@@ -0,0 +1,76 @@
+/**
+ * @file   Benchmark.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/xiao_marco.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+BEGIN_NAMESPACE(xiao)
+
+// The thread counts of the scaling benchmarks.
+static const size_t xBenchThreadCounts[] = { 1, 4, 16, 64 };
+
+// Return the seconds taken by fn().
+inline double timeIt(const std::function<void()>& fn)
+{
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start)
+		.count();
+}
+
+// Run fn(i) on n threads released together, return the seconds from the
+// release to the end of the last one.
+inline double runThreads(size_t n, const std::function<void(size_t)>& fn)
+{
+	std::atomic<bool> go{ false };
+	std::vector<std::thread> threads;
+	threads.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		threads.emplace_back([&go, &fn, i]() {
+			while (!go.load(std::memory_order_acquire))
+				std::this_thread::yield();
+			fn(i);
+		});
+	}
+	return timeIt([&]() {
+		go.store(true, std::memory_order_release);
+		for (auto& thread : threads)
+			thread.join();
+	});
+}
+
+inline void printResult(const char* name,
+	size_t threads,
+	uint64_t ops,
+	double seconds)
+{
+	printf("%-36s %3zu threads %10.1f ns/op %10.2f Mops/s\n",
+		name,
+		threads,
+		seconds * 1e9 / static_cast<double>(ops),
+		static_cast<double>(ops) / seconds / 1e6);
+	fflush(stdout);
+}
+
+// The benchmarks, see BenchMain.cpp.
+void benchMpscQueue();
+void benchTaskQueue();
+void benchTimingWheel();
+void benchAsyncLogger();
+void benchLogFormat();
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,123 @@
+/**
+ * @file   LogFormatBench.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// A LOG_INFO line with 4 ints and 2 doubles, with the numbers written by
+// LogStream against the way LogStream wrote them before: the digits of an
+// integer one at a time and reversed, the doubles with snprintf("%.12g").
+// The lines go to an output function which does nothing.
+
+#include "Benchmark.h"
+#include <xiao/utils/Logger.h>
+#include <algorithm>
+#include <random>
+#include <string.h>
+
+BEGIN_NAMESPACE(xiao)
+
+static const uint64_t xLines = 2 * 1000 * 1000;
+
+// Stream the value the old way.
+struct OldInt
+{
+	int value_;
+};
+
+struct OldDouble
+{
+	double value_;
+};
+
+static LogStream& operator<<(LogStream& stream, OldInt v)
+{
+	static const char digits[] = "9876543210123456789";
+	static const char* zero = digits + 9;
+	char buf[32];
+	int i = v.value_;
+	char* p = buf;
+	do
+	{
+		int lsd = i % 10;
+		i /= 10;
+		*p++ = zero[lsd];
+	} while (i != 0);
+	if (v.value_ < 0)
+		*p++ = '-';
+	std::reverse(buf, p);
+	stream.append(buf, p - buf);
+	return stream;
+}
+
+static LogStream& operator<<(LogStream& stream, OldDouble v)
+{
+	char buf[32];
+	int len = snprintf(buf, sizeof(buf), "%.12g", v.value_);
+	stream.append(buf, len);
+	return stream;
+}
+
+struct LineArgs
+{
+	int ints_[4];
+	double doubles_[2];
+};
+
+static std::vector<LineArgs> makeArgs()
+{
+	std::mt19937_64 rng(42);
+	std::uniform_int_distribution<int> ints(-1000000, 1000000);
+	std::uniform_real_distribution<double> doubles(0.0, 1000.0);
+	std::vector<LineArgs> args(1024);
+	for (auto& arg : args)
+	{
+		for (auto& i : arg.ints_)
+			i = ints(rng);
+		for (auto& d : arg.doubles_)
+			d = doubles(rng);
+	}
+	return args;
+}
+
+void benchLogFormat()
+{
+	auto args = makeArgs();
+	Logger::setOutputFunction([](const char*, const uint64_t) {}, []() {});
+
+	double seconds = timeIt([&]() {
+		for (uint64_t n = 0; n < xLines; ++n)
+		{
+			auto& arg = args[n % args.size()];
+			LOG_INFO << "id=" << arg.ints_[0] << " status=" << arg.ints_[1]
+					 << " bytes=" << arg.ints_[2] << " retries=" << arg.ints_[3]
+					 << " latency=" << arg.doubles_[0]
+					 << " ratio=" << arg.doubles_[1];
+		}
+	});
+	printResult("LOG_INFO 4 ints 2 doubles, LogStream", 1, xLines, seconds);
+
+	seconds = timeIt([&]() {
+		for (uint64_t n = 0; n < xLines; ++n)
+		{
+			auto& arg = args[n % args.size()];
+			LOG_INFO << "id=" << OldInt{ arg.ints_[0] }
+					 << " status=" << OldInt{ arg.ints_[1] }
+					 << " bytes=" << OldInt{ arg.ints_[2] }
+					 << " retries=" << OldInt{ arg.ints_[3] }
+					 << " latency=" << OldDouble{ arg.doubles_[0] }
+					 << " ratio=" << OldDouble{ arg.doubles_[1] };
+		}
+	});
+	printResult("LOG_INFO 4 ints 2 doubles, snprintf", 1, xLines, seconds);
+
+	Logger::setOutputFunction(
+		[](const char* msg, const uint64_t len) {
+			fwrite(msg, 1, static_cast<size_t>(len), stdout);
+		},
+		[]() { fflush(stdout); });
+}
+
+END_NAMESPACE(xiao)
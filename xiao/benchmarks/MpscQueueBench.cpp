@@ -0,0 +1,120 @@
+/**
+ * @file   MpscQueueBench.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// MpscQueue with inline elements and recycled nodes against the previous
+// implementation, which allocated a node and an element per enqueue.
+
+#include "Benchmark.h"
+#include <xiao/utils/LockFreeQueue.h>
+#include <xiao/utils/NonCopyable.h>
+
+BEGIN_NAMESPACE(xiao)
+
+// The MpscQueue before the node recycling.
+template <typename T>
+class AllocatingMpscQueue : public NonCopyable
+{
+public:
+	AllocatingMpscQueue()
+		: head_(new BufferNode), tail_(head_.load(std::memory_order_relaxed))
+	{
+	}
+	~AllocatingMpscQueue()
+	{
+		T output;
+		while (this->dequeue(output))
+		{
+		}
+		delete head_.load(std::memory_order_relaxed);
+	}
+
+	void enqueue(T&& input)
+	{
+		BufferNode* node{ new BufferNode(std::move(input)) };
+		BufferNode* prevhead{ head_.exchange(node, std::memory_order_acq_rel) };
+		prevhead->next_.store(node, std::memory_order_release);
+	}
+
+	bool dequeue(T& output)
+	{
+		BufferNode* tail = tail_.load(std::memory_order_relaxed);
+		BufferNode* next = tail->next_.load(std::memory_order_acquire);
+		if (next == nullptr)
+		{
+			return false;
+		}
+		output = std::move(*(next->dataPtr_));
+		delete next->dataPtr_;
+		tail_.store(next, std::memory_order_release);
+		delete tail;
+		return true;
+	}
+
+private:
+	struct BufferNode
+	{
+		BufferNode() = default;
+		BufferNode(T&& data) : dataPtr_(new T(std::move(data)))
+		{
+		}
+		T* dataPtr_{ nullptr };
+		std::atomic<BufferNode*> next_{ nullptr };
+	};
+
+	std::atomic<BufferNode*> head_;
+	std::atomic<BufferNode*> tail_;
+};
+
+// The producers enqueue ops elements in total while one consumer dequeues
+// them, return the seconds taken.
+template <typename Queue>
+static double runMpsc(size_t producers, uint64_t ops)
+{
+	Queue queue;
+	uint64_t perProducer = ops / producers;
+	uint64_t total = perProducer * producers;
+	uint64_t sum = 0;
+	double seconds = runThreads(producers + 1, [&](size_t i) {
+		if (i == producers)
+		{
+			uint64_t value;
+			for (uint64_t n = 0; n < total;)
+			{
+				if (queue.dequeue(value))
+				{
+					sum += value;
+					++n;
+				}
+			}
+			return;
+		}
+		for (uint64_t n = 0; n < perProducer; ++n)
+			queue.enqueue(uint64_t(n));
+	});
+	if (sum != producers * (perProducer * (perProducer - 1) / 2))
+		fprintf(stderr, "wrong sum %llu\n", static_cast<unsigned long long>(sum));
+	return seconds;
+}
+
+void benchMpscQueue()
+{
+	const uint64_t ops = 4 * 1000 * 1000;
+	for (auto producers : xBenchThreadCounts)
+	{
+		printResult("MpscQueue (recycled nodes)",
+			producers,
+			ops,
+			runMpsc<MpscQueue<uint64_t>>(producers, ops));
+		printResult("MpscQueue (allocating, before)",
+			producers,
+			ops,
+			runMpsc<AllocatingMpscQueue<uint64_t>>(producers, ops));
+	}
+}
+
+END_NAMESPACE(xiao)
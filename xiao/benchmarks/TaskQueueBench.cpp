@@ -0,0 +1,103 @@
+/**
+ * @file   TaskQueueBench.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// ConcurrentTaskQueue in work-stealing mode against the shared queue under
+// one mutex, from 1 to 64 workers. The tasks are submitted from outside the
+// pool, or forked by the workers, which push them to their own deques in
+// work-stealing mode.
+
+#include "Benchmark.h"
+#include <xiao/utils/ConcurrentTaskQueue.h>
+#include <future>
+
+BEGIN_NAMESPACE(xiao)
+
+// Count the tasks run, the last one fulfills the promise.
+struct TaskCounter
+{
+	explicit TaskCounter(uint64_t total) : total_(total)
+	{
+	}
+	void done()
+	{
+		if (count_.fetch_add(1, std::memory_order_relaxed) + 1 == total_)
+			finished_.set_value();
+	}
+	void wait()
+	{
+		finished_.get_future().wait();
+	}
+	const uint64_t total_;
+	std::atomic<uint64_t> count_{ 0 };
+	std::promise<void> finished_;
+};
+
+static double runSubmitted(ConcurrentTaskQueue::ScheduleMode mode,
+	size_t workers,
+	uint64_t tasks)
+{
+	ConcurrentTaskQueue queue(workers, "bench", mode);
+	TaskCounter counter(tasks);
+	double seconds = timeIt([&]() {
+		for (uint64_t i = 0; i < tasks; ++i)
+			queue.runTaskInQueue([&counter]() { counter.done(); });
+		counter.wait();
+	});
+	queue.stop();
+	return seconds;
+}
+
+static double runForked(ConcurrentTaskQueue::ScheduleMode mode,
+	size_t workers,
+	uint64_t tasks)
+{
+	// every root task forks xChildren tasks from its worker
+	const uint64_t xChildren = 100;
+	uint64_t roots = tasks / (xChildren + 1);
+	ConcurrentTaskQueue queue(workers, "bench", mode);
+	TaskCounter counter(roots * (xChildren + 1));
+	double seconds = timeIt([&]() {
+		for (uint64_t i = 0; i < roots; ++i)
+		{
+			queue.runTaskInQueue([&queue, &counter, xChildren]() {
+				for (uint64_t n = 0; n < xChildren; ++n)
+					queue.runTaskInQueue([&counter]() { counter.done(); });
+				counter.done();
+			});
+		}
+		counter.wait();
+	});
+	queue.stop();
+	return seconds;
+}
+
+void benchTaskQueue()
+{
+	const uint64_t tasks = 1000 * 1000;
+	for (auto workers : xBenchThreadCounts)
+	{
+		printResult("submitted, work stealing",
+			workers,
+			tasks,
+			runSubmitted(ConcurrentTaskQueue::xWorkStealing, workers, tasks));
+		printResult("submitted, shared queue",
+			workers,
+			tasks,
+			runSubmitted(ConcurrentTaskQueue::xSharedQueue, workers, tasks));
+		printResult("forked by workers, work stealing",
+			workers,
+			tasks,
+			runForked(ConcurrentTaskQueue::xWorkStealing, workers, tasks));
+		printResult("forked by workers, shared queue",
+			workers,
+			tasks,
+			runForked(ConcurrentTaskQueue::xSharedQueue, workers, tasks));
+	}
+}
+
+END_NAMESPACE(xiao)
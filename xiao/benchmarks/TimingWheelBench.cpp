@@ -0,0 +1,102 @@
+/**
+ * @file   TimingWheelBench.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// Refreshing the idle timeouts of 200k connections in a TimingWheel against
+// a std::priority_queue of deadlines. The heap takes a new deadline per
+// refresh and drops the stale ones when they come out on expiry. The wheel
+// isn't ticked during the run, its ticks cost a bucket swap per second.
+
+#include "Benchmark.h"
+#include <xiao/utils/TimingWheel.h>
+#include <xiao/net/EventLoop.h>
+#include <functional>
+#include <queue>
+#include <random>
+
+BEGIN_NAMESPACE(xiao)
+
+static const size_t xConnections = 200 * 1000;
+static const size_t xRefreshes = 4 * 1000 * 1000;
+
+// The connection to refresh for every refresh.
+static std::vector<uint32_t> refreshOrder()
+{
+	std::minstd_rand rng(42);
+	std::vector<uint32_t> order(xRefreshes);
+	for (auto& index : order)
+		index = static_cast<uint32_t>(rng() % xConnections);
+	return order;
+}
+
+static double runWheel(size_t timeout, const std::vector<uint32_t>& order)
+{
+	EventLoop loop;
+	TimingWheel wheel(&loop, 2 * timeout);
+	std::vector<EntryPtr> entries(xConnections);
+	for (auto& entry : entries)
+	{
+		entry = std::make_shared<int>(0);
+		wheel.insertEntryInloop(timeout, entry);
+	}
+	return timeIt([&]() {
+		for (auto index : order)
+			wheel.insertEntryInloop(timeout, entries[index]);
+	});
+}
+
+static double runHeap(size_t timeout, const std::vector<uint32_t>& order)
+{
+	using Deadline = std::pair<uint64_t, uint32_t>;
+	std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>
+		heap;
+	std::vector<uint64_t> deadlines(xConnections, timeout);
+	for (uint32_t i = 0; i < xConnections; ++i)
+		heap.emplace(timeout, i);
+	size_t expired = 0;
+	double seconds = timeIt([&]() {
+		// a second passes every xConnections refreshes
+		uint64_t now = 0;
+		for (size_t n = 0; n < order.size(); ++n)
+		{
+			auto index = order[n];
+			deadlines[index] = now + timeout;
+			heap.emplace(now + timeout, index);
+			if ((n + 1) % xConnections == 0)
+			{
+				++now;
+				while (!heap.empty() && heap.top().first <= now)
+				{
+					if (deadlines[heap.top().second] == heap.top().first)
+						++expired;
+					heap.pop();
+				}
+			}
+		}
+	});
+	if (expired == xConnections + 1)
+		printf("unreachable\n");
+	return seconds;
+}
+
+void benchTimingWheel()
+{
+	auto order = refreshOrder();
+	for (size_t timeout : { 60, 600 })
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "TimingWheel, timeout %zus", timeout);
+		printResult(name, 1, order.size(), runWheel(timeout, order));
+		snprintf(name,
+			sizeof(name),
+			"std::priority_queue, timeout %zus",
+			timeout);
+		printResult(name, 1, order.size(), runHeap(timeout, order));
+	}
+}
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,113 @@
+/**
+ * @file   Channel.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/net/Channel.h>
+#include <xiao/net/EventLoop.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+using namespace xiao;
+
+#ifdef __linux__
+const int Channel::xNoneEvent = 0;
+const int Channel::xReadEvent = EPOLLIN | EPOLLPRI;
+const int Channel::xWriteEvent = EPOLLOUT;
+#else
+const int Channel::xNoneEvent = 0;
+const int Channel::xReadEvent = POLLIN | POLLPRI;
+const int Channel::xWriteEvent = POLLOUT;
+#endif
+
+Channel::Channel(EventLoop* loop, int fd)
+	: loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), tied_(false)
+{
+}
+
+void Channel::remove()
+{
+	assert(events_ == xNoneEvent);
+	loop_->removeChannel(this);
+}
+
+void Channel::update()
+{
+	loop_->updateChannel(this);
+}
+
+void Channel::handleEvent()
+{
+	if (events_ == xNoneEvent)
+		return;
+	if (tied_)
+	{
+		std::shared_ptr<void> guard = tie_.lock();
+		if (guard)
+		{
+			handleEventSafely();
+		}
+	}
+	else
+	{
+		handleEventSafely();
+	}
+}
+
+void Channel::handleEventSafely()
+{
+	if (eventCallback_)
+	{
+		eventCallback_();
+		return;
+	}
+#ifdef __linux__
+	if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN))
+	{
+		if (closeCallback_)
+			closeCallback_();
+	}
+	if (revents_ & EPOLLERR)
+	{
+		if (errorCallback_)
+			errorCallback_();
+	}
+	if (revents_ & (EPOLLIN | EPOLLPRI | EPOLLRDHUP))
+	{
+		if (readCallback_)
+			readCallback_();
+	}
+	if (revents_ & EPOLLOUT)
+	{
+		if (writeCallback_)
+			writeCallback_();
+	}
+#else
+	if ((revents_ & POLLHUP) && !(revents_ & POLLIN))
+	{
+		if (closeCallback_)
+			closeCallback_();
+	}
+	if (revents_ & (POLLNVAL | POLLERR))
+	{
+		if (errorCallback_)
+			errorCallback_();
+	}
+	if (revents_ & (POLLIN | POLLPRI))
+	{
+		if (readCallback_)
+			readCallback_();
+	}
+	if (revents_ & POLLOUT)
+	{
+		if (writeCallback_)
+			writeCallback_();
+	}
+#endif // __linux__
+}
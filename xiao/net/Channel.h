@@ -0,0 +1,221 @@
+/**
+ * @file   Channel.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <assert.h>
+
+BEGIN_NAMESPACE(xiao)
+
+class EventLoop;
+
+/**
+ * @brief This class binds a file descriptor to an event loop. The events of
+ * interest are registered in the poller of the loop, and the callbacks are
+ * called in the loop thread when the events occur.
+ */
+class XIAO_EXPORT Channel : NonCopyable
+{
+public:
+	using EventCallback = std::function<void()>;
+
+	/**
+	 * @brief Construct a new Channel instance.
+	 *
+	 * \param loop The event loop in which the channel works.
+	 * \param fd The file descriptor of the channel.
+	 */
+	Channel(EventLoop* loop, int fd);
+
+	void setReadCallback(const EventCallback& cb)
+	{
+		readCallback_ = cb;
+	}
+	void setReadCallback(EventCallback&& cb)
+	{
+		readCallback_ = std::move(cb);
+	}
+
+	void setWriteCallback(const EventCallback& cb)
+	{
+		writeCallback_ = cb;
+	}
+	void setWriteCallback(EventCallback&& cb)
+	{
+		writeCallback_ = std::move(cb);
+	}
+
+	void setCloseCallback(const EventCallback& cb)
+	{
+		closeCallback_ = cb;
+	}
+	void setCloseCallback(EventCallback&& cb)
+	{
+		closeCallback_ = std::move(cb);
+	}
+
+	void setErrorCallback(const EventCallback& cb)
+	{
+		errorCallback_ = cb;
+	}
+	void setErrorCallback(EventCallback&& cb)
+	{
+		errorCallback_ = std::move(cb);
+	}
+
+	/**
+	 * @brief Set the event callback. If it is set, the other callbacks are
+	 * ignored and this one is called for every event.
+	 */
+	void setEventCallback(const EventCallback& cb)
+	{
+		eventCallback_ = cb;
+	}
+	void setEventCallback(EventCallback&& cb)
+	{
+		eventCallback_ = std::move(cb);
+	}
+
+	int fd() const
+	{
+		return fd_;
+	}
+
+	int events() const
+	{
+		return events_;
+	}
+
+	int revents() const
+	{
+		return revents_;
+	}
+
+	bool isNoneEvent() const
+	{
+		return events_ == xNoneEvent;
+	}
+
+	/**
+	 * @brief Disable all events of the channel.
+	 */
+	void disableAll()
+	{
+		events_ = xNoneEvent;
+		update();
+	}
+
+	/**
+	 * @brief Remove the channel from the poller. disableAll() must be called
+	 * first.
+	 */
+	void remove();
+
+	EventLoop* ownerLoop()
+	{
+		return loop_;
+	}
+
+	void enableReading()
+	{
+		events_ |= xReadEvent;
+		update();
+	}
+
+	void disableReading()
+	{
+		events_ &= ~xReadEvent;
+		update();
+	}
+
+	void enableWriting()
+	{
+		events_ |= xWriteEvent;
+		update();
+	}
+
+	void disableWriting()
+	{
+		events_ &= ~xWriteEvent;
+		update();
+	}
+
+	bool isWriting() const
+	{
+		return events_ & xWriteEvent;
+	}
+
+	bool isReading() const
+	{
+		return events_ & xReadEvent;
+	}
+
+	/**
+	 * @brief Set the events of interest directly.
+	 */
+	void updateEvents(int events)
+	{
+		events_ = events;
+		update();
+	}
+
+	/**
+	 * @brief Tie the channel to an object, the callbacks are not called after
+	 * the object is destroyed.
+	 */
+	void tie(const std::shared_ptr<void>& obj)
+	{
+		tie_ = obj;
+		tied_ = true;
+	}
+
+	static const int xNoneEvent;
+	static const int xReadEvent;
+	static const int xWriteEvent;
+
+private:
+	friend class EventLoop;
+	friend class EpollPoller;
+
+	void update();
+	void handleEvent();
+	void handleEventSafely();
+
+	int setRevents(int revt)
+	{
+		revents_ = revt;
+		return revt;
+	}
+
+	int index()
+	{
+		return index_;
+	}
+
+	void setIndex(int index)
+	{
+		index_ = index;
+	}
+
+	EventLoop* loop_;
+	const int fd_;
+	int events_;
+	int revents_;
+	int index_;
+	EventCallback readCallback_;
+	EventCallback writeCallback_;
+	EventCallback errorCallback_;
+	EventCallback closeCallback_;
+	EventCallback eventCallback_;
+	std::weak_ptr<void> tie_;
+	bool tied_;
+};
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,293 @@
+/**
+ * @file   EventLoop.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/net/EventLoop.h>
+#include <xiao/net/Channel.h>
+#include <xiao/utils/Logger.h>
+#include "Poller.h"
+#include "TimerQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif // __linux__
+
+using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+static constexpr int xPollTimeMs{ 10000 };
+thread_local EventLoop* t_loopInThisThread = nullptr;
+
+#ifdef __linux__
+int createEventfd()
+{
+	int evtfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (evtfd < 0)
+	{
+		LOG_SYSERR << "Failed in eventfd";
+		abort();
+	}
+	return evtfd;
+}
+#endif // __linux__
+END_NAMESPACE(xiao)
+
+EventLoop::EventLoop()
+	: looping_(false),
+	threadId_(std::this_thread::get_id()),
+	quit_(false),
+	poller_(Poller::newPoller(this)),
+	timerQueue_(new TimerQueue(this)),
+	currentActiveChannel_(nullptr),
+	eventHandling_(false),
+	threadLocalLoopPtr_(&t_loopInThisThread)
+{
+	if (t_loopInThisThread)
+	{
+		LOG_FATAL << "There is already an EventLoop in this thread";
+		exit(-1);
+	}
+	t_loopInThisThread = this;
+#ifdef __linux__
+	wakeupFd_ = createEventfd();
+#else
+	int fds[2];
+	if (::pipe(fds) < 0)
+	{
+		LOG_SYSERR << "Failed to create pipe";
+		abort();
+	}
+	for (int fd : fds)
+	{
+		::fcntl(fd, F_SETFL, O_NONBLOCK);
+		::fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+	wakeupFd_ = fds[0];
+	wakeupWriteFd_ = fds[1];
+#endif // __linux__
+	wakeupChannelPtr_ = std::unique_ptr<Channel>(new Channel(this, wakeupFd_));
+	wakeupChannelPtr_->setReadCallback(std::bind(&EventLoop::wakeupRead, this));
+	wakeupChannelPtr_->enableReading();
+}
+
+EventLoop::~EventLoop()
+{
+	quit();
+
+	// Spin waiting for the loop to exit because this may take a while since
+	// the poll() may be blocking.
+	while (looping_.load(std::memory_order_acquire))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	*threadLocalLoopPtr_ = nullptr;
+	::close(wakeupFd_);
+#ifndef __linux__
+	::close(wakeupWriteFd_);
+#endif // !__linux__
+}
+
+EventLoop* EventLoop::getEventLoopOfCurrentThread()
+{
+	return t_loopInThisThread;
+}
+
+void EventLoop::updateChannel(Channel* channel)
+{
+	assert(channel->ownerLoop() == this);
+	assertInLoopThread();
+	poller_->updateChannel(channel);
+}
+
+void EventLoop::removeChannel(Channel* channel)
+{
+	assert(channel->ownerLoop() == this);
+	assertInLoopThread();
+	if (eventHandling_)
+	{
+		assert(currentActiveChannel_ == channel ||
+			std::find(activeChannels_.begin(), activeChannels_.end(),
+				channel) == activeChannels_.end());
+	}
+	poller_->removeChannel(channel);
+}
+
+void EventLoop::quit()
+{
+	quit_.store(true, std::memory_order_release);
+
+	if (!isInLoopThread())
+	{
+		wakeup();
+	}
+}
+
+void EventLoop::loop()
+{
+	assert(!looping_);
+	assertInLoopThread();
+	looping_.store(true, std::memory_order_release);
+	quit_.store(false, std::memory_order_release);
+
+	while (!quit_.load(std::memory_order_acquire))
+	{
+		activeChannels_.clear();
+#ifdef __linux__
+		poller_->poll(xPollTimeMs, &activeChannels_);
+#else
+		poller_->poll(static_cast<int>(timerQueue_->getTimeout()),
+			&activeChannels_);
+		timerQueue_->processTimers();
+#endif // __linux__
+		eventHandling_ = true;
+		for (auto it = activeChannels_.begin(); it != activeChannels_.end(); ++it)
+		{
+			currentActiveChannel_ = *it;
+			currentActiveChannel_->handleEvent();
+		}
+		currentActiveChannel_ = nullptr;
+		eventHandling_ = false;
+		doRunInLoopFuncs();
+	}
+	Func f;
+	while (funcsOnQuit_.dequeue(f))
+	{
+		f();
+	}
+	looping_.store(false, std::memory_order_release);
+}
+
+void EventLoop::abortNotInLoopThread()
+{
+	LOG_FATAL << "It is forbidden to run loop on threads other than event-loop "
+		"thread";
+	exit(1);
+}
+
+void EventLoop::queueInLoop(const Func& cb)
+{
+	funcs_.enqueue(cb);
+	if (!isInLoopThread() || !looping_.load(std::memory_order_acquire))
+	{
+		wakeup();
+	}
+}
+
+void EventLoop::queueInLoop(Func&& cb)
+{
+	funcs_.enqueue(std::move(cb));
+	if (!isInLoopThread() || !looping_.load(std::memory_order_acquire))
+	{
+		wakeup();
+	}
+}
+
+TimerId EventLoop::runAt(const Date& time, const Func& cb)
+{
+	auto microSeconds =
+		time.microSecondsSinceEpoch() - Date::now().microSecondsSinceEpoch();
+	std::chrono::steady_clock::time_point tp =
+		std::chrono::steady_clock::now() +
+		std::chrono::microseconds(microSeconds);
+	return timerQueue_->addTimer(cb, tp, std::chrono::microseconds(0));
+}
+
+TimerId EventLoop::runAt(const Date& time, Func&& cb)
+{
+	auto microSeconds =
+		time.microSecondsSinceEpoch() - Date::now().microSecondsSinceEpoch();
+	std::chrono::steady_clock::time_point tp =
+		std::chrono::steady_clock::now() +
+		std::chrono::microseconds(microSeconds);
+	return timerQueue_->addTimer(std::move(cb),
+		tp,
+		std::chrono::microseconds(0));
+}
+
+TimerId EventLoop::runAfter(double delay, const Func& cb)
+{
+	return runAt(Date::date().after(delay), cb);
+}
+
+TimerId EventLoop::runAfter(double delay, Func&& cb)
+{
+	return runAt(Date::date().after(delay), std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, const Func& cb)
+{
+	std::chrono::microseconds dur(
+		static_cast<std::chrono::microseconds::rep>(interval * 1000000));
+	auto tp = std::chrono::steady_clock::now() + dur;
+	return timerQueue_->addTimer(cb, tp, dur);
+}
+
+TimerId EventLoop::runEvery(double interval, Func&& cb)
+{
+	std::chrono::microseconds dur(
+		static_cast<std::chrono::microseconds::rep>(interval * 1000000));
+	auto tp = std::chrono::steady_clock::now() + dur;
+	return timerQueue_->addTimer(std::move(cb), tp, dur);
+}
+
+void EventLoop::invalidateTimer(TimerId id)
+{
+	timerQueue_->invalidateTimer(id);
+}
+
+void EventLoop::runOnQuit(Func&& cb)
+{
+	funcsOnQuit_.enqueue(std::move(cb));
+}
+
+void EventLoop::runOnQuit(const Func& cb)
+{
+	funcsOnQuit_.enqueue(cb);
+}
+
+void EventLoop::doRunInLoopFuncs()
+{
+	callingFuncs_ = true;
+	// The tasks queued while running are handled in the same round, the loop
+	// is not woken up again for them.
+	while (!funcs_.empty())
+	{
+		Func func;
+		while (funcs_.dequeue(func))
+		{
+			func();
+		}
+	}
+	callingFuncs_ = false;
+}
+
+void EventLoop::wakeup()
+{
+	uint64_t one = 1;
+#ifdef __linux__
+	ssize_t n = ::write(wakeupFd_, &one, sizeof one);
+#else
+	ssize_t n = ::write(wakeupWriteFd_, &one, sizeof one);
+#endif // __linux__
+	(void)n;
+}
+
+void EventLoop::wakeupRead()
+{
+	uint64_t tmp;
+	ssize_t ret = ::read(wakeupFd_, &tmp, sizeof(tmp));
+	if (ret < 0)
+	{
+		LOG_SYSERR << "wakeup read error";
+	}
+}
@@ -0,0 +1,243 @@
+/**
+ * @file   EventLoop.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/utils/LockFreeQueue.h>
+#include <xiao/utils/Date.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <limits>
+#include <chrono>
+
+BEGIN_NAMESPACE(xiao)
+
+class Poller;
+class TimerQueue;
+class Channel;
+using ChannelList = std::vector<Channel*>;
+using Func = std::function<void()>;
+using TimerId = uint64_t;
+enum
+{
+	InvalidTimerId = 0
+};
+
+/**
+ * @brief This class represents an event loop, one loop per thread. IO events
+ * are dispatched by the poller, and tasks from other threads are injected
+ * through a lock-free queue followed by an eventfd wakeup.
+ */
+class XIAO_EXPORT EventLoop : NonCopyable
+{
+public:
+	EventLoop();
+	~EventLoop();
+
+	/**
+	 * @brief Run the event loop. This method will be blocked until the event
+	 * loop exits.
+	 */
+	void loop();
+
+	/**
+	 * @brief Let the event loop quit. It's safe to call this method from any
+	 * thread.
+	 */
+	void quit();
+
+	/**
+	 * @brief Assert that the current thread is the thread which the event loop
+	 * belongs to. If the assertion fails, the program aborts.
+	 */
+	void assertInLoopThread()
+	{
+		if (!isInLoopThread())
+		{
+			abortNotInLoopThread();
+		}
+	};
+
+	/**
+	 * @brief Return true if the current thread is the thread which the event
+	 * loop belongs to.
+	 */
+	bool isInLoopThread() const
+	{
+		return threadId_ == std::this_thread::get_id();
+	}
+
+	/**
+	 * @brief Get the event loop of the current thread. Return nullptr if
+	 * there is no event loop in the current thread.
+	 */
+	static EventLoop* getEventLoopOfCurrentThread();
+
+	/**
+	 * @brief Run the function f in the thread of the event loop. If called in
+	 * the loop thread, f is executed immediately, otherwise it is queued.
+	 *
+	 * \param f
+	 */
+	template <typename Functor>
+	inline void runInLoop(Functor&& f)
+	{
+		if (isInLoopThread())
+		{
+			f();
+		}
+		else
+		{
+			queueInLoop(std::forward<Functor>(f));
+		}
+	}
+
+	/**
+	 * @brief Queue the function f to the end of the task queue of the event
+	 * loop. The submission path is lock-free, so it's cheap to call from many
+	 * threads concurrently.
+	 *
+	 * \param f
+	 */
+	void queueInLoop(const Func& f);
+	void queueInLoop(Func&& f);
+
+	/**
+	 * @brief Run a function at a time point.
+	 *
+	 * \param time The time to run the function.
+	 * \param cb The function to run.
+	 * \return TimerId The ID of the timer.
+	 */
+	TimerId runAt(const Date& time, const Func& cb);
+	TimerId runAt(const Date& time, Func&& cb);
+
+	/**
+	 * @brief Run a function after a period of time.
+	 *
+	 * \param delay Represent the period of time in seconds.
+	 * \param cb The function to run.
+	 * \return TimerId The ID of the timer.
+	 */
+	TimerId runAfter(double delay, const Func& cb);
+	TimerId runAfter(double delay, Func&& cb);
+
+	/**
+	 * @brief Run a function after a period of time, represented by a
+	 * std::chrono::duration.
+	 */
+	TimerId runAfter(const std::chrono::duration<double>& delay, const Func& cb)
+	{
+		return runAfter(delay.count(), cb);
+	}
+	TimerId runAfter(const std::chrono::duration<double>& delay, Func&& cb)
+	{
+		return runAfter(delay.count(), std::move(cb));
+	}
+
+	/**
+	 * @brief Repeatedly run a function every period of time.
+	 *
+	 * \param interval The duration in seconds.
+	 * \param cb The function to run.
+	 * \return TimerId The ID of the timer.
+	 */
+	TimerId runEvery(double interval, const Func& cb);
+	TimerId runEvery(double interval, Func&& cb);
+
+	TimerId runEvery(const std::chrono::duration<double>& interval,
+		const Func& cb)
+	{
+		return runEvery(interval.count(), cb);
+	}
+	TimerId runEvery(const std::chrono::duration<double>& interval, Func&& cb)
+	{
+		return runEvery(interval.count(), std::move(cb));
+	}
+
+	/**
+	 * @brief Invalidate the timer identified by the given ID. It's safe to
+	 * call this method from any thread.
+	 */
+	void invalidateTimer(TimerId id);
+
+	/**
+	 * @brief Register a function which is called when the event loop quits.
+	 */
+	void runOnQuit(Func&& cb);
+	void runOnQuit(const Func& cb);
+
+	/**
+	 * @brief Update (add or modify) the channel in the poller. It must be
+	 * called in the loop thread.
+	 */
+	void updateChannel(Channel* chl);
+
+	/**
+	 * @brief Remove the channel from the poller. It must be called in the loop
+	 * thread.
+	 */
+	void removeChannel(Channel* chl);
+
+	/**
+	 * @brief Return the index of the event loop, used by the thread pool of
+	 * event loops.
+	 */
+	size_t index()
+	{
+		return index_;
+	}
+
+	void setIndex(size_t index)
+	{
+		index_ = index;
+	}
+
+	bool isRunning()
+	{
+		return looping_.load(std::memory_order_acquire) &&
+			(!quit_.load(std::memory_order_acquire));
+	}
+
+	bool isCallingFunctions()
+	{
+		return callingFuncs_;
+	}
+
+private:
+	void abortNotInLoopThread();
+	void wakeup();
+	void wakeupRead();
+	void doRunInLoopFuncs();
+
+	std::atomic<bool> looping_;
+	std::thread::id threadId_;
+	std::atomic<bool> quit_;
+	std::unique_ptr<Poller> poller_;
+	std::unique_ptr<TimerQueue> timerQueue_;
+
+	ChannelList activeChannels_;
+	Channel* currentActiveChannel_;
+
+	bool eventHandling_;
+	MpscQueue<Func> funcs_;
+	bool callingFuncs_{ false };
+	int wakeupFd_;
+#ifndef __linux__
+	int wakeupWriteFd_;
+#endif // !__linux__
+	std::unique_ptr<Channel> wakeupChannelPtr_;
+	MpscQueue<Func> funcsOnQuit_;
+	size_t index_{ std::numeric_limits<size_t>::max() };
+	EventLoop** threadLocalLoopPtr_;
+};
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,26 @@
+/**
+ * @file   Poller.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include "Poller.h"
+#ifdef __linux__
+#include "poller/EpollPoller.h"
+#endif // __linux__
+#include <xiao/utils/Logger.h>
+
+using namespace xiao;
+
+Poller* Poller::newPoller(EventLoop* loop)
+{
+#ifdef __linux__
+	return new EpollPoller(loop);
+#else
+	(void)loop;
+	LOG_FATAL << "No poller backend is available on this platform";
+	return nullptr;
+#endif // __linux__
+}
@@ -0,0 +1,45 @@
+/**
+ * @file   Poller.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/net/EventLoop.h>
+#include <vector>
+
+BEGIN_NAMESPACE(xiao)
+
+class Channel;
+
+/**
+ * @brief This class is the interface of the IO multiplexing backends. A poller
+ * is owned by exactly one event loop and is only used in the loop thread.
+ */
+class Poller : NonCopyable
+{
+public:
+	explicit Poller(EventLoop* loop) : ownerLoop_(loop){};
+	virtual ~Poller()
+	{
+	}
+
+	void assertInLoopThread()
+	{
+		ownerLoop_->assertInLoopThread();
+	}
+
+	virtual void poll(int timeoutMs, ChannelList* activeChannels) = 0;
+	virtual void updateChannel(Channel* channel) = 0;
+	virtual void removeChannel(Channel* channel) = 0;
+
+	static Poller* newPoller(EventLoop* loop);
+
+private:
+	EventLoop* ownerLoop_;
+};
+
+END_NAMESPACE(xiao)
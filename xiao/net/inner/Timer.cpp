@@ -0,0 +1,62 @@
+/**
+ * @file   Timer.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include "Timer.h"
+
+using namespace xiao;
+
+std::atomic<TimerId> Timer::timersCreated_{ InvalidTimerId };
+
+Timer::Timer(const TimerCallback& cb,
+	const TimePoint& when,
+	const TimeInterval& interval)
+	: callback_(cb),
+	when_(when),
+	interval_(interval),
+	repeat_(interval.count() > 0),
+	id_(++timersCreated_)
+{
+}
+
+Timer::Timer(TimerCallback&& cb,
+	const TimePoint& when,
+	const TimeInterval& interval)
+	: callback_(std::move(cb)),
+	when_(when),
+	interval_(interval),
+	repeat_(interval.count() > 0),
+	id_(++timersCreated_)
+{
+}
+
+void Timer::run() const
+{
+	callback_();
+}
+
+void Timer::restart(const TimePoint& now)
+{
+	if (repeat_)
+	{
+		when_ = now + interval_;
+	}
+	else
+	{
+		when_ = std::chrono::steady_clock::now();
+	}
+}
+
+bool Timer::operator<(const Timer& t) const
+{
+	return when_ < t.when_;
+}
+
+bool Timer::operator>(const Timer& t) const
+{
+	return when_ > t.when_;
+}
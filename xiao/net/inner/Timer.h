@@ -0,0 +1,68 @@
+/**
+ * @file   Timer.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/net/EventLoop.h>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+BEGIN_NAMESPACE(xiao)
+
+using TimerCallback = std::function<void()>;
+using TimePoint = std::chrono::steady_clock::time_point;
+using TimeInterval = std::chrono::microseconds;
+
+class Timer : public NonCopyable
+{
+public:
+	Timer(const TimerCallback& cb,
+		const TimePoint& when,
+		const TimeInterval& interval);
+	Timer(TimerCallback&& cb,
+		const TimePoint& when,
+		const TimeInterval& interval);
+	~Timer()
+	{
+	}
+
+	void run() const;
+	void restart(const TimePoint& now);
+
+	bool operator<(const Timer& t) const;
+	bool operator>(const Timer& t) const;
+
+	const TimePoint& when() const
+	{
+		return when_;
+	}
+
+	bool isRepeat()
+	{
+		return repeat_;
+	}
+
+	TimerId id()
+	{
+		return id_;
+	}
+
+private:
+	TimerCallback callback_;
+	TimePoint when_;
+	const TimeInterval interval_;
+	const bool repeat_;
+	const TimerId id_;
+	static std::atomic<TimerId> timersCreated_;
+};
+
+using TimerPtr = std::shared_ptr<Timer>;
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,70 @@
+/**
+ * @file   TimerQueue.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/net/EventLoop.h>
+#include "Timer.h"
+#include <queue>
+#include <memory>
+#include <unordered_set>
+
+BEGIN_NAMESPACE(xiao)
+
+struct TimerPtrComparer
+{
+	bool operator()(const TimerPtr& x, const TimerPtr& y) const
+	{
+		return *x > *y;
+	}
+};
+
+/**
+ * @brief This class keeps the timers of an event loop in a min-heap ordered by
+ * expiration. On Linux the earliest expiration is armed on a timerfd, on other
+ * platforms the loop polls with the timeout returned by getTimeout().
+ */
+class TimerQueue : NonCopyable
+{
+public:
+	explicit TimerQueue(EventLoop* loop);
+	~TimerQueue();
+
+	TimerId addTimer(const TimerCallback& cb,
+		const TimePoint& when,
+		const TimeInterval& interval);
+	TimerId addTimer(TimerCallback&& cb,
+		const TimePoint& when,
+		const TimeInterval& interval);
+	void addTimerInLoop(const TimerPtr& timer);
+	void invalidateTimer(TimerId id);
+#ifndef __linux__
+	int64_t getTimeout() const;
+	void processTimers();
+#endif // !__linux__
+
+protected:
+	EventLoop* loop_;
+#ifdef __linux__
+	int timerfd_;
+	std::shared_ptr<Channel> timerfdChannelPtr_;
+	void handleRead();
+#endif // __linux__
+	std::priority_queue<TimerPtr, std::vector<TimerPtr>, TimerPtrComparer>
+		timers_;
+
+	bool callingExpiredTimers_;
+	bool insert(const TimerPtr& timePtr);
+	void reset(const std::vector<TimerPtr>& expired, const TimePoint& now);
+	std::vector<TimerPtr> getExpired(const TimePoint& now);
+
+private:
+	std::unordered_set<TimerId> timerIdSet_;
+};
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,176 @@
+/**
+ * @file   EpollPoller.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#ifdef __linux__
+#include "EpollPoller.h"
+#include <xiao/net/Channel.h>
+#include <xiao/utils/Logger.h>
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+static_assert(EPOLLIN == POLLIN, "EPOLLIN != POLLIN");
+static_assert(EPOLLPRI == POLLPRI, "EPOLLPRI != POLLPRI");
+static_assert(EPOLLOUT == POLLOUT, "EPOLLOUT != POLLOUT");
+static_assert(EPOLLRDHUP == POLLRDHUP, "EPOLLRDHUP != POLLRDHUP");
+static_assert(EPOLLERR == POLLERR, "EPOLLERR != POLLERR");
+static_assert(EPOLLHUP == POLLHUP, "EPOLLHUP != POLLHUP");
+
+namespace
+{
+	const int xNew = -1;
+	const int xAdded = 1;
+	const int xDeleted = 2;
+}
+END_NAMESPACE(xiao)
+
+EpollPoller::EpollPoller(EventLoop* loop)
+	: Poller(loop),
+	epollfd_(::epoll_create1(EPOLL_CLOEXEC)),
+	events_(xInitEventListSize)
+{
+	if (epollfd_ < 0)
+	{
+		LOG_SYSERR << "epoll_create1 failed";
+	}
+}
+
+EpollPoller::~EpollPoller()
+{
+	close(epollfd_);
+}
+
+void EpollPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+	int numEvents = ::epoll_wait(epollfd_,
+		&*events_.begin(),
+		static_cast<int>(events_.size()),
+		timeoutMs);
+	int savedErrno = errno;
+	if (numEvents > 0)
+	{
+		fillActiveChannels(numEvents, activeChannels);
+		if (static_cast<size_t>(numEvents) == events_.size())
+		{
+			events_.resize(events_.size() * 2);
+		}
+	}
+	else if (numEvents < 0)
+	{
+		if (savedErrno != EINTR)
+		{
+			errno = savedErrno;
+			LOG_SYSERR << "EpollPoller::poll()";
+		}
+	}
+}
+
+void EpollPoller::fillActiveChannels(int numEvents,
+	ChannelList* activeChannels) const
+{
+	assert(static_cast<size_t>(numEvents) <= events_.size());
+	for (int i = 0; i < numEvents; ++i)
+	{
+		Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
+#ifndef NDEBUG
+		int fd = channel->fd();
+		ChannelMap::const_iterator it = channels_.find(fd);
+		assert(it != channels_.end());
+		assert(it->second == channel);
+#endif
+		channel->setRevents(events_[i].events);
+		activeChannels->push_back(channel);
+	}
+}
+
+void EpollPoller::updateChannel(Channel* channel)
+{
+	assertInLoopThread();
+	assert(channel->fd() >= 0);
+
+	const int index = channel->index();
+	if (index == xNew || index == xDeleted)
+	{
+		// a new one, add with EPOLL_CTL_ADD
+#ifndef NDEBUG
+		int fd = channel->fd();
+		if (index == xNew)
+		{
+			assert(channels_.find(fd) == channels_.end());
+			channels_[fd] = channel;
+		}
+		else
+		{
+			assert(channels_.find(fd) != channels_.end());
+			assert(channels_[fd] == channel);
+		}
+#endif
+		channel->setIndex(xAdded);
+		update(EPOLL_CTL_ADD, channel);
+	}
+	else
+	{
+		// update existing one with EPOLL_CTL_MOD/DEL
+#ifndef NDEBUG
+		int fd = channel->fd();
+		(void)fd;
+		assert(channels_.find(fd) != channels_.end());
+		assert(channels_[fd] == channel);
+#endif
+		assert(index == xAdded);
+		if (channel->isNoneEvent())
+		{
+			update(EPOLL_CTL_DEL, channel);
+			channel->setIndex(xDeleted);
+		}
+		else
+		{
+			update(EPOLL_CTL_MOD, channel);
+		}
+	}
+}
+
+void EpollPoller::removeChannel(Channel* channel)
+{
+	assertInLoopThread();
+#ifndef NDEBUG
+	int fd = channel->fd();
+	assert(channels_.find(fd) != channels_.end());
+	assert(channels_[fd] == channel);
+	assert(channel->isNoneEvent());
+	size_t n = channels_.erase(fd);
+	(void)n;
+	assert(n == 1);
+#endif
+	int index = channel->index();
+	assert(index == xAdded || index == xDeleted);
+	if (index == xAdded)
+	{
+		update(EPOLL_CTL_DEL, channel);
+	}
+	channel->setIndex(xNew);
+}
+
+void EpollPoller::update(int operation, Channel* channel)
+{
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = channel->events();
+	event.data.ptr = channel;
+	int fd = channel->fd();
+	if (::epoll_ctl(epollfd_, operation, fd, &event) < 0)
+	{
+		LOG_SYSERR << "epoll_ctl op =" << operation << " fd =" << fd;
+	}
+}
+#endif // __linux__
@@ -0,0 +1,45 @@
+/**
+ * @file   EpollPoller.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include "../Poller.h"
+#include <sys/epoll.h>
+#include <vector>
+#ifndef NDEBUG
+#include <map>
+#endif
+
+BEGIN_NAMESPACE(xiao)
+
+/**
+ * @brief This class implements the poller with epoll. Active channels are
+ * stored in the data pointer of epoll_event, so no lookup is needed when
+ * dispatching events.
+ */
+class EpollPoller : public Poller
+{
+public:
+	explicit EpollPoller(EventLoop* loop);
+	virtual ~EpollPoller();
+	virtual void poll(int timeoutMs, ChannelList* activeChannels) override;
+	virtual void updateChannel(Channel* channel) override;
+	virtual void removeChannel(Channel* channel) override;
+
+private:
+	static const int xInitEventListSize = 16;
+	int epollfd_;
+	std::vector<struct epoll_event> events_;
+	void update(int operation, Channel* channel);
+#ifndef NDEBUG
+	using ChannelMap = std::map<int, Channel*>;
+	ChannelMap channels_;
+#endif
+	void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
+};
+
+END_NAMESPACE(xiao)
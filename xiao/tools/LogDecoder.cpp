@@ -0,0 +1,476 @@
+/**
+ * @file   LogDecoder.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+// xiao_log_decoder renders the binary logs written by the LOG_BIN_* macros
+// as the text logs of xiao::Logger, the formats are the ones of LOG_*_FMT.
+//
+// usage: xiao_log_decoder [-l] file...
+//   -l  display the local time instead of UTC
+//
+// The site records of all the files are read first, so the rotated files of
+// one run can be decoded together. With BinaryLogger::attach() every file
+// starts with the site records and can also be decoded alone.
+
+#include <xiao/utils/BinaryLog.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+BEGIN_NAMESPACE(xiao)
+
+struct DecodedSite
+{
+	Logger::LogLevel level_{ Logger::xInfo };
+	int32_t line_{ 0 };
+	std::string argTypes_;
+	std::string file_;
+	std::string format_;
+};
+
+struct DecodedArg
+{
+	char type_{ 'i' };
+	int64_t int_{ 0 };
+	uint64_t uint_{ 0 };
+	double double_{ 0 };
+	std::string str_;
+};
+
+static const char* logLevelStr[Logger::LogLevel::xNumberofLogLevels] = {
+	" TRACE ",
+	" DEBUG ",
+	" INFO  ",
+	" WARN  ",
+	" ERROR ",
+	" FATAL ",
+};
+
+// A cursor over a record which fails instead of reading past the end.
+class RecordReader
+{
+public:
+	RecordReader(const char* data, size_t len) : cur_(data), end_(data + len)
+	{
+	}
+
+	template <typename T>
+	bool read(T& value)
+	{
+		if (static_cast<size_t>(end_ - cur_) < sizeof(T))
+			return false;
+		memcpy(&value, cur_, sizeof(T));
+		cur_ += sizeof(T);
+		return true;
+	}
+
+	bool read(std::string& value, size_t len)
+	{
+		if (static_cast<size_t>(end_ - cur_) < len)
+			return false;
+		value.assign(cur_, len);
+		cur_ += len;
+		return true;
+	}
+
+private:
+	const char* cur_;
+	const char* end_;
+};
+
+class LogDecoder
+{
+public:
+	explicit LogDecoder(bool localTime) : localTime_(localTime)
+	{
+	}
+
+	// Call fn(type, record, length) for every record and fn(0, line, length)
+	// for every line of text.
+	template <typename F>
+	static void forEachRecord(const std::string& data, F&& fn)
+	{
+		size_t pos = 0;
+		while (pos < data.size())
+		{
+			const char* p = data.data() + pos;
+			size_t left = data.size() - pos;
+			uint16_t magic;
+			uint32_t length = 0;
+			if (left >= xBinaryHeaderSize)
+			{
+				memcpy(&magic, p, sizeof(magic));
+				memcpy(&length, p + 4, sizeof(length));
+			}
+			if (left >= xBinaryHeaderSize && magic == xBinaryLogMagic &&
+				length >= xBinaryHeaderSize && length <= left &&
+				(p[2] == xBinarySiteRecord || p[2] == xBinaryEntryRecord))
+			{
+				fn(static_cast<uint8_t>(p[2]), p, length);
+				pos += length;
+				continue;
+			}
+			auto newline = data.find('\n', pos);
+			size_t lineEnd = newline == std::string::npos ? data.size()
+														  : newline + 1;
+			fn(0, p, lineEnd - pos);
+			pos = lineEnd;
+		}
+	}
+
+	void addSite(const char* record, size_t len)
+	{
+		RecordReader reader(record + xBinaryHeaderSize,
+			len - xBinaryHeaderSize);
+		uint32_t id;
+		uint8_t level, argCount;
+		uint16_t fileLength, formatLength;
+		DecodedSite site;
+		if (!reader.read(id) || !reader.read(level) ||
+			!reader.read(site.line_) || !reader.read(argCount) ||
+			!reader.read(site.argTypes_, argCount) ||
+			!reader.read(fileLength) || !reader.read(site.file_, fileLength) ||
+			!reader.read(formatLength) ||
+			!reader.read(site.format_, formatLength) ||
+			level >= Logger::xNumberofLogLevels)
+		{
+			fprintf(stderr, "Bad site record\n");
+			return;
+		}
+		site.level_ = static_cast<Logger::LogLevel>(level);
+		sites_[id] = std::move(site);
+	}
+
+	void renderEntry(const char* record, size_t len, std::string& out)
+	{
+		RecordReader reader(record + xBinaryHeaderSize,
+			len - xBinaryHeaderSize);
+		uint32_t id;
+		int64_t microSeconds;
+		uint64_t threadId;
+		if (!reader.read(id) || !reader.read(microSeconds) ||
+			!reader.read(threadId))
+		{
+			out.append("<bad record>\n");
+			return;
+		}
+		auto iter = sites_.find(id);
+		if (iter == sites_.end())
+		{
+			out.append("<unknown site ").append(std::to_string(id)).append(
+				">\n");
+			return;
+		}
+		const DecodedSite& site = iter->second;
+		std::vector<DecodedArg> args(site.argTypes_.size());
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			if (!readArg(reader, site.argTypes_[i], args[i]))
+			{
+				out.append("<truncated record>\n");
+				return;
+			}
+		}
+		renderTime(microSeconds, out);
+		out.append(std::to_string(threadId));
+		out.append(logLevelStr[site.level_]);
+		renderMessage(site.format_, args, out);
+		out.append(" - ").append(site.file_).append(":").append(
+			std::to_string(site.line_));
+		out.push_back('\n');
+	}
+
+private:
+	static bool readArg(RecordReader& reader, char type, DecodedArg& arg)
+	{
+		arg.type_ = type;
+		switch (type)
+		{
+		case 'i':
+			return reader.read(arg.int_);
+		case 'u':
+		case 'p':
+			return reader.read(arg.uint_);
+		case 'f':
+			return reader.read(arg.double_);
+		case 'c':
+		case 'b':
+		{
+			char c;
+			if (!reader.read(c))
+				return false;
+			arg.int_ = c;
+			return true;
+		}
+		case 's':
+		{
+			uint32_t len;
+			return reader.read(len) && reader.read(arg.str_, len);
+		}
+		default:
+			return false;
+		}
+	}
+
+	void renderTime(int64_t microSeconds, std::string& out)
+	{
+		time_t seconds = static_cast<time_t>(microSeconds / 1000000);
+		struct tm tmTime;
+#ifndef _WIN32
+		if (localTime_)
+			localtime_r(&seconds, &tmTime);
+		else
+			gmtime_r(&seconds, &tmTime);
+#else
+		if (localTime_)
+			localtime_s(&tmTime, &seconds);
+		else
+			gmtime_s(&tmTime, &seconds);
+#endif
+		char buf[64];
+		size_t n = strftime(buf, sizeof(buf), "%Y%m%d %H:%M:%S", &tmTime);
+		out.append(buf, n);
+		snprintf(buf,
+			sizeof(buf),
+			localTime_ ? ".%06d " : ".%06d UTC ",
+			static_cast<int>(microSeconds % 1000000));
+		out.append(buf);
+	}
+
+	template <typename T>
+	static std::string formatted(const std::string& conversion, T value)
+	{
+		char buf[256];
+		int n = snprintf(buf, sizeof(buf), conversion.c_str(), value);
+		if (n < 0)
+			return std::string();
+		if (static_cast<size_t>(n) < sizeof(buf))
+			return std::string(buf, n);
+		std::string large(n + 1, '\0');
+		snprintf(&large[0], large.size(), conversion.c_str(), value);
+		large.resize(n);
+		return large;
+	}
+
+	static std::string formatBinary(uint64_t value, bool alternate)
+	{
+		std::string digits;
+		do
+		{
+			digits.push_back(static_cast<char>('0' + (value & 1)));
+			value >>= 1;
+		} while (value != 0);
+		if (alternate)
+			digits.append("b0");
+		return std::string(digits.rbegin(), digits.rend());
+	}
+
+	// Render an argument by the specification of its replacement field, as
+	// LOG_*_FMT does. The flags and the zero padding are left to printf, the
+	// fill and the alignment are applied here.
+	static void renderArg(std::string& out,
+		const internal::FormatSpec& spec,
+		const DecodedArg& arg)
+	{
+		bool zeroPad = spec.zeroPad_ && spec.align_ == '\0';
+		std::string conversion("%");
+		if (spec.sign_ != '-')
+			conversion.push_back(spec.sign_);
+		if (spec.alternate_)
+			conversion.push_back('#');
+		if (zeroPad)
+			conversion.append("0").append(std::to_string(spec.width_));
+		std::string text;
+		char defaultAlign = '>';
+		switch (arg.type_)
+		{
+		case 'i':
+		case 'u':
+		case 'c':
+			if (spec.type_ == 'c' || (arg.type_ == 'c' && spec.type_ == '\0'))
+			{
+				text.push_back(static_cast<char>(
+					arg.type_ == 'u' ? arg.uint_ : arg.int_));
+				defaultAlign = '<';
+			}
+			else if (spec.type_ == 'b')
+			{
+				text = formatBinary(
+					arg.type_ == 'u' ? arg.uint_
+									 : static_cast<uint64_t>(arg.int_),
+					spec.alternate_);
+			}
+			else if (arg.type_ == 'u')
+			{
+				text = formatted(conversion + "ll" +
+						(spec.type_ == '\0' || spec.type_ == 'd' ? 'u'
+																 : spec.type_),
+					static_cast<unsigned long long>(arg.uint_));
+			}
+			else
+			{
+				text = formatted(conversion + "ll" +
+						(spec.type_ == '\0' ? 'd' : spec.type_),
+					static_cast<long long>(arg.int_));
+			}
+			break;
+		case 'b':
+			// a bool takes {} or {:s}
+			text = arg.int_ ? "true" : "false";
+			defaultAlign = '<';
+			break;
+		case 'p':
+			text = formatted(std::string("0x%llx"),
+				static_cast<unsigned long long>(arg.uint_));
+			break;
+		case 'f':
+			if (spec.type_ == '\0' && spec.precision_ < 0)
+			{
+				// the shortest text which reads back the same value
+				for (int precision = 15; precision <= 17; ++precision)
+				{
+					text = formatted(
+						conversion + "." + std::to_string(precision) + "g",
+						arg.double_);
+					if (strtod(text.c_str(), nullptr) == arg.double_)
+						break;
+				}
+			}
+			else
+			{
+				if (spec.precision_ >= 0)
+					conversion.append(".").append(
+						std::to_string(spec.precision_));
+				text = formatted(
+					conversion + (spec.type_ == '\0' ? 'g' : spec.type_),
+					arg.double_);
+			}
+			break;
+		case 's':
+			text = spec.precision_ >= 0
+				? arg.str_.substr(0, static_cast<size_t>(spec.precision_))
+				: arg.str_;
+			defaultAlign = '<';
+			break;
+		}
+		size_t width = static_cast<size_t>(spec.width_);
+		if (zeroPad || text.size() >= width)
+		{
+			out.append(text);
+			return;
+		}
+		size_t padding = width - text.size();
+		char align = spec.align_ ? spec.align_ : defaultAlign;
+		size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+		out.append(before, spec.fill_);
+		out.append(text);
+		out.append(padding - before, spec.fill_);
+	}
+
+	static void renderMessage(const std::string& format,
+		const std::vector<DecodedArg>& args,
+		std::string& out)
+	{
+		// the format was checked when the log was compiled
+		const char* fmt = format.c_str();
+		size_t pos = 0;
+		size_t next = 0;
+		while (pos < format.size())
+		{
+			auto piece = internal::nextFormatPiece(fmt, pos);
+			out.append(fmt + piece.literalBegin_, piece.literalLength_);
+			if (!piece.hasArg_)
+				continue;
+			if (next < args.size())
+				renderArg(out, piece.spec_, args[next++]);
+			else
+				out.append("{}");
+		}
+	}
+
+	bool localTime_;
+	std::map<uint32_t, DecodedSite> sites_;
+};
+
+END_NAMESPACE(xiao)
+
+using namespace xiao;
+
+static bool readFile(const char* name, std::string& data)
+{
+	FILE* fp = strcmp(name, "-") == 0 ? stdin : fopen(name, "rb");
+	if (!fp)
+	{
+		fprintf(stderr, "Can't open %s\n", name);
+		return false;
+	}
+	char buf[64 * 1024];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+	{
+		data.append(buf, n);
+	}
+	if (fp != stdin)
+		fclose(fp);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	bool localTime = false;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-l") == 0)
+			localTime = true;
+		else
+			files.emplace_back(argv[i]);
+	}
+	if (files.empty())
+	{
+		fprintf(stderr, "usage: %s [-l] file...\n", argv[0]);
+		return 1;
+	}
+	std::vector<std::string> contents(files.size());
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (!readFile(files[i].c_str(), contents[i]))
+			return 1;
+	}
+
+	LogDecoder decoder(localTime);
+	for (auto& data : contents)
+	{
+		LogDecoder::forEachRecord(data,
+			[&decoder](uint8_t type, const char* record, size_t len) {
+				if (type == xBinarySiteRecord)
+					decoder.addSite(record, len);
+			});
+	}
+	std::string out;
+	for (auto& data : contents)
+	{
+		LogDecoder::forEachRecord(
+			data, [&decoder, &out](uint8_t type, const char* record, size_t len) {
+				if (type == xBinaryEntryRecord)
+					decoder.renderEntry(record, len, out);
+				else if (type == 0)
+					out.append(record, len);
+				if (out.size() >= 64 * 1024)
+				{
+					fwrite(out.data(), 1, out.size(), stdout);
+					out.clear();
+				}
+			});
+	}
+	fwrite(out.data(), 1, out.size(), stdout);
+	return 0;
+}
@@ -6,149 +6,785 @@
  * @date   2024-5-26 
  */
 #include <xiao/utils/AsyncFileLogger.h>
+#include <xiao/utils/BinaryLog.h>
+#include <xiao/utils/ConcurrentTaskQueue.h>
+#include <xiao/utils/IoUring.h>
 #include <xiao/utils/Utilities.h>
+#include <algorithm>
 #include <functional>
 #include <iostream>
+#include <vector>
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#if !defined(_WIN32) || defined(__MINGW32__)
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+#ifdef XIAO_HAS_IO_URING
+#include <linux/io_uring.h>
+#endif
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 BEGIN_NAMESPACE(xiao)
 static constexpr std::chrono::seconds xLogFlushTimeout{ 1 };
-static constexpr size_t xMemBufferSize{ 4 * 1024 * 1024 };
+// The default size of the staging buffer of every thread. A longer log line
+// gets its own buffer.
+static constexpr size_t xDefaultBufferSize{ 64 * 1024 };
+// The max number of idle staging buffers kept for reuse.
+static constexpr size_t xMaxFreeBuffers{ 256 };
+static constexpr uint64_t xDefaultMaxBufferedBytes{ 100 * 1024 * 1024 };
+// The max number of buffers written with one writev() call.
+#ifdef IOV_MAX
+static constexpr size_t xMaxIovecs{ IOV_MAX < 64 ? IOV_MAX : 64 };
+#else
+static constexpr size_t xMaxIovecs{ 16 };
+#endif
+#ifndef _WIN32
+static constexpr size_t xDirectIoAlignment{ 4096 };
+static constexpr size_t xDirectBufferSize{ 1024 * 1024 };
+#endif
+// The size of the io_uring queues and the max number of writes in flight.
+static constexpr unsigned xIoUringEntries{ 32 };
+static constexpr size_t xMaxInflightWrites{ 8 };
 extern const char* strerror_tl(int savedErrno);
+
+static std::atomic<uint64_t> s_loggerId{ 0 };
+// Marks a staging buffer taken by the writer thread while it's published.
+static std::string s_publishingBuffer;
+
+// The rotated files are compressed by chunks of this size.
+static constexpr size_t xCompressChunkSize{ 128 * 1024 };
+
+static const char* compressionSuffix(AsyncFileLogger::Compression compression)
+{
+	switch (compression)
+	{
+	case AsyncFileLogger::xGzip:
+		return ".gz";
+	case AsyncFileLogger::xZstd:
+		return ".zst";
+	default:
+		return "";
+	}
+}
+
+// The length of the name without the suffix of a compressed file.
+static size_t rawNameLength(const std::string& name)
+{
+	for (auto compression : { AsyncFileLogger::xGzip, AsyncFileLogger::xZstd })
+	{
+		size_t len = strlen(compressionSuffix(compression));
+		if (name.size() > len &&
+			name.compare(name.size() - len,
+				len,
+				compressionSuffix(compression)) == 0)
+			return name.size() - len;
+	}
+	return name.size();
+}
+
+// Skip the bytes written by a short write, return the number of the vectors
+// left.
+static int skipWritten(struct iovec*& iter, int count, size_t written)
+{
+	while (count > 0 && written >= iter->iov_len)
+	{
+		written -= iter->iov_len;
+		++iter;
+		--count;
+	}
+	if (count > 0)
+	{
+		iter->iov_base = static_cast<char*>(iter->iov_base) + written;
+		iter->iov_len -= written;
+	}
+	return count;
+}
+
+#ifdef USE_ZLIB
+static bool gzipFile(FILE* in, const std::string& dst, int level)
+{
+	char mode[8];
+	if (level >= 0 && level <= 9)
+		snprintf(mode, sizeof(mode), "wb%d", level);
+	else
+		snprintf(mode, sizeof(mode), "wb");
+	gzFile out = gzopen(dst.c_str(), mode);
+	if (!out)
+		return false;
+	gzbuffer(out, xCompressChunkSize);
+	std::vector<char> buf(xCompressChunkSize);
+	bool ok = true;
+	size_t n;
+	while (ok && (n = fread(buf.data(), 1, buf.size(), in)) > 0)
+	{
+		ok = gzwrite(out, buf.data(), static_cast<unsigned>(n)) ==
+			static_cast<int>(n);
+	}
+	ok = gzclose(out) == Z_OK && ok && !ferror(in);
+	return ok;
+}
+#endif
+
+#ifdef USE_ZSTD
+static bool zstdFile(FILE* in, const std::string& dst, int level)
+{
+	FILE* out = fopen(dst.c_str(), "wb");
+	if (!out)
+		return false;
+	ZSTD_CCtx* cctx = ZSTD_createCCtx();
+	if (level >= 0)
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+	std::vector<char> inBuf(ZSTD_CStreamInSize());
+	std::vector<char> outBuf(ZSTD_CStreamOutSize());
+	bool ok = true;
+	bool last = false;
+	while (ok && !last)
+	{
+		size_t n = fread(inBuf.data(), 1, inBuf.size(), in);
+		last = n < inBuf.size();
+		ZSTD_inBuffer input = { inBuf.data(), n, 0 };
+		// a frame is ended after the last chunk
+		ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+		bool finished = false;
+		while (ok && !finished)
+		{
+			ZSTD_outBuffer output = { outBuf.data(), outBuf.size(), 0 };
+			size_t remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+			if (ZSTD_isError(remaining))
+			{
+				ok = false;
+				break;
+			}
+			ok = fwrite(outBuf.data(), 1, output.pos, out) == output.pos;
+			finished = last ? remaining == 0 : input.pos == input.size;
+		}
+	}
+	ZSTD_freeCCtx(cctx);
+	ok = fclose(out) == 0 && ok && !ferror(in);
+	return ok;
+}
+#endif
+
+// The staging buffers used by the current thread, one per logger. When the
+// thread exits, its buffers are released to their loggers for reuse. The
+// registry shares the ownership of the buffers, so the flags stay valid if a
+// logger is destroyed before the thread exits.
+struct ThreadBufferRegistry
+{
+	struct Entry
+	{
+		uint64_t loggerId_;
+		std::shared_ptr<void> buffer_;
+		std::atomic<bool>* inUse_;
+	};
+	std::vector<Entry> entries_;
+	~ThreadBufferRegistry()
+	{
+		for (auto& entry : entries_)
+			entry.inUse_->store(false, std::memory_order_release);
+	}
+};
+static thread_local ThreadBufferRegistry t_threadBuffers;
 END_NAMESPACE(xiao)
 
 using namespace xiao;
 
+// A batch of buffers written with one writev(), or the fsync of a rotated
+// file when io_uring is used. The request lives until its completion.
+struct AsyncFileLogger::IoRequest
+{
+	enum Type
+	{
+		xWrite,
+		xSync
+	};
+	Type type_{ xWrite };
+	std::string* bufs_[xMaxIovecs];
+	size_t bufCount_{ 0 };
+	struct iovec vecs_[xMaxIovecs + 1];
+	int vecCount_{ 0 };
+	// the bytes of bufs_, and of all the vectors
+	uint64_t bytes_{ 0 };
+	uint64_t length_{ 0 };
+	char lostMsg_[128];
+	// the file written and the offset of vecs_[firstVec_], the vectors
+	// before it are written by a short write; the file closed after the fsync
+	int fd_{ -1 };
+	uint64_t offset_{ 0 };
+	int firstVec_{ 0 };
+};
+
 AsyncFileLogger::AsyncFileLogger()
-	: logBufferPtr_(new std::string), nextBufferPtr_(new std::string)
+	: loggerId_(++s_loggerId),
+	freeBuffers_(xMaxFreeBuffers),
+	bufferSize_(xDefaultBufferSize),
+	maxBufferedBytes_(xDefaultMaxBufferedBytes)
 {
-	logBufferPtr_->reserve(xMemBufferSize);
-	nextBufferPtr_->reserve(xMemBufferSize);
 }
 
 AsyncFileLogger::~AsyncFileLogger()
 {
-	stopFlag_ = true;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopFlag_ = true;
+	}
 	if (threadPtr_)
 	{
 		cond_.notify_all();
 		threadPtr_->join();
 	}
+	collectThreadBuffers();
+	writePendingBuffers();
+	// the housekeeper is still running, the ring is drained below
+	loggerFilePtr_.reset();
+	if (ring_)
+	{
+		// the old file is synced and closed through the ring as well
+		while (ring_->inflight() > 0)
+		{
+			reapCompletions(1);
+		}
+		for (auto request : freeIoRequests_)
+		{
+			delete request;
+		}
+	}
+
+	std::string* buf;
+	while (freeBuffers_.tryPop(buf))
+	{
+		delete buf;
+	}
+	auto node = threadBuffers_.load();
+	while (node)
+	{
+		auto next = node->next_;
+		delete node;
+		node = next;
+	}
+	if (spillFp_)
+		fclose(spillFp_);
+}
+
+AsyncFileLogger::ThreadBuffer* AsyncFileLogger::getThreadBuffer()
+{
+	auto& entries = t_threadBuffers.entries_;
+	for (auto& entry : entries)
+	{
+		if (entry.loggerId_ == loggerId_)
+			return static_cast<ThreadBuffer*>(entry.buffer_.get());
+	}
+	// reuse a buffer released by an exited thread, or add a new one.
+	ThreadBufferPtr threadBuffer;
+	for (auto node = threadBuffers_.load(std::memory_order_acquire); node;
+		 node = node->next_)
 	{
-		std::lock_guard<std::mutex> guard_(mutex_);
-		if (logBufferPtr_->length() > 0)
+		bool inUse = false;
+		if (node->buffer_->inUse_.compare_exchange_strong(inUse, true))
 		{
-			writeBuffers_.push(logBufferPtr_);
+			threadBuffer = node->buffer_;
+			break;
 		}
-		while (!writeBuffers_.empty())
+	}
+	if (!threadBuffer)
+	{
+		threadBuffer = std::make_shared<ThreadBuffer>();
+		auto node = new ThreadBufferNode;
+		node->buffer_ = threadBuffer;
+		node->next_ = threadBuffers_.load(std::memory_order_relaxed);
+		while (!threadBuffers_.compare_exchange_weak(node->next_,
+			node,
+			std::memory_order_release,
+			std::memory_order_relaxed))
 		{
-			StringPtr tmpPtr = (StringPtr&&)writeBuffers_.front();
-			writeBuffers_.pop();
-			writeLogToFile(tmpPtr);
 		}
 	}
+	entries.push_back({ loggerId_, threadBuffer, &threadBuffer->inUse_ });
+	return threadBuffer.get();
+}
+
+std::string* AsyncFileLogger::newBuffer(size_t len)
+{
+	std::string* buf;
+	size_t bufferSize = bufferSize_.load(std::memory_order_relaxed);
+	if (len <= bufferSize && freeBuffers_.tryPop(buf))
+		return buf;
+	buf = new std::string;
+	buf->reserve(std::max<size_t>(len, bufferSize));
+	return buf;
+}
+
+void AsyncFileLogger::recycleBuffer(std::string* buf)
+{
+	if (buf->capacity() < 2 * bufferSize_.load(std::memory_order_relaxed))
+	{
+		buf->clear();
+		if (freeBuffers_.tryPush(buf))
+			return;
+	}
+	delete buf;
+}
+
+void AsyncFileLogger::publishBuffer(std::string* buf)
+{
+	pendingBytes_.fetch_add(buf->length());
+	writeBuffers_.enqueue(buf);
+	// pendingBytes_ is increased before writerSleeping_ is read, and the
+	// writer sets writerSleeping_ before it reads pendingBytes_, so the
+	// writer either sees the buffer or gets notified.
+	if (writerSleeping_.load())
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		cond_.notify_one();
+	}
 }
 
 void AsyncFileLogger::output(const char* msg, const uint64_t len)
 {
-	std::lock_guard<std::mutex> guard_(mutex_);
-	if (len > xMemBufferSize)
+	output(msg, len, Logger::outputLevel());
+}
+
+void AsyncFileLogger::output(const char* msg,
+	const uint64_t len,
+	Logger::LogLevel level)
+{
+	// The site records of the binary logs are never dropped, the entries of
+	// the site would be undecodable.
+	bool siteRecord = len >= xBinaryHeaderSize &&
+		memcmp(msg, &xBinaryLogMagic, sizeof(xBinaryLogMagic)) == 0 &&
+		static_cast<uint8_t>(msg[2]) == xBinarySiteRecord;
+	if (!siteRecord && !admit(msg, len, level))
 		return;
-	if (!logBufferPtr_)
+	ThreadBuffer* threadBuffer = getThreadBuffer();
+	std::string* buf = threadBuffer->buffer_.load(std::memory_order_relaxed);
+	for (;;)
 	{
-		logBufferPtr_ = std::make_shared<std::string>();
-		logBufferPtr_->reserve(xMemBufferSize);
+		// Wait for the writer to publish the buffer it took, so the logs of
+		// this thread are queued in order.
+		if (buf == &s_publishingBuffer)
+		{
+			std::this_thread::yield();
+			buf = threadBuffer->buffer_.load(std::memory_order_relaxed);
+		}
+		else if (threadBuffer->buffer_.compare_exchange_weak(buf,
+					 nullptr,
+					 std::memory_order_acquire,
+					 std::memory_order_relaxed))
+		{
+			break;
+		}
 	}
-	if (logBufferPtr_->capacity() - logBufferPtr_->length() < len)
+	if (buf && buf->capacity() - buf->length() < len)
 	{
-		swapBuffer();
-		cond_.notify_one();
+		publishBuffer(buf);
+		buf = nullptr;
 	}
-	if (writeBuffers_.size() > 25) // 100M bytes logs in buffer
+	if (!buf)
 	{
-		++lostCounter_;
-		return;
+		buf = newBuffer(static_cast<size_t>(len));
+	}
+	buf->append(msg, static_cast<size_t>(len));
+	if (len > bufferSize_.load(std::memory_order_relaxed))
+	{
+		publishBuffer(buf);
+		buf = nullptr;
+	}
+	threadBuffer->buffer_.store(buf, std::memory_order_release);
+}
+
+bool AsyncFileLogger::admit(const char* msg,
+	const uint64_t len,
+	Logger::LogLevel level)
+{
+	auto policy = policy_.load(std::memory_order_relaxed);
+	uint64_t limit = maxBufferedBytes_.load(std::memory_order_relaxed);
+	if (policy == xDropLowSeverity && level < Logger::xError)
+	{
+		// 4/8 for trace and debug, 6/8 for info, 7/8 for warn
+		static const uint64_t eighths[] = { 4, 4, 6, 7 };
+		limit = limit / 8 * eighths[level];
+	}
+	if (pendingBytes_.load(std::memory_order_relaxed) + len <= limit)
+		return true;
+	if (policy == xBlockWithTimeout && waitForRoom(len))
+		return true;
+	if (policy == xSpillToFile && spill(msg, len))
+		return false;
+	lostCounter_.fetch_add(1, std::memory_order_relaxed);
+	droppedLines_.fetch_add(1, std::memory_order_relaxed);
+	droppedBytes_.fetch_add(len, std::memory_order_relaxed);
+	return false;
+}
+
+bool AsyncFileLogger::waitForRoom(const uint64_t len)
+{
+	auto start = std::chrono::steady_clock::now();
+	bool hasRoom;
+	{
+		std::unique_lock<std::mutex> lock(roomMutex_);
+		blockedThreads_.fetch_add(1);
+		auto timeout = blockTimeout_.load(std::memory_order_relaxed);
+		hasRoom = roomCond_.wait_until(lock, start + timeout, [&]() {
+			return pendingBytes_.load() + len <= maxBufferedBytes_.load() ||
+				stopFlag_;
+		});
+		blockedThreads_.fetch_sub(1);
 	}
+	auto stall = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start);
+	stallTimeUs_.fetch_add(stall.count(), std::memory_order_relaxed);
+	return hasRoom;
+}
 
-	if (lostCounter_ > 0)
+bool AsyncFileLogger::spill(const char* msg, const uint64_t len)
+{
+	std::lock_guard<std::mutex> lock(spillMutex_);
+	if (!spillFp_)
 	{
-		char logErr[128];
-		auto strlen =
-			snprintf(logErr,
-				sizeof(logErr),
-				"%llu log information is lost\n",
-				static_cast<long long unsigned int>(lostCounter_));
-		lostCounter_ = 0;
-		logBufferPtr_->append(logErr, strlen);
+		if (spillFileName_.empty())
+			spillFileName_ =
+				filePath_ + fileBaseName_ + ".spill" + fileExtName_;
+		spillFp_ = fopen(spillFileName_.c_str(), "a");
+		if (!spillFp_)
+			return false;
 	}
-	logBufferPtr_->append(msg, len);
+	if (fwrite(msg, 1, static_cast<size_t>(len), spillFp_) != len)
+		return false;
+	spilledBytes_.fetch_add(len, std::memory_order_relaxed);
+	return true;
+}
+
+AsyncFileLogger::BackpressureStats AsyncFileLogger::getBackpressureStats()
+	const
+{
+	BackpressureStats stats;
+	stats.droppedLines_ = droppedLines_.load(std::memory_order_relaxed);
+	stats.droppedBytes_ = droppedBytes_.load(std::memory_order_relaxed);
+	stats.spilledBytes_ = spilledBytes_.load(std::memory_order_relaxed);
+	stats.stallTime_ = std::chrono::microseconds(
+		stallTimeUs_.load(std::memory_order_relaxed));
+	return stats;
 }
 
 void AsyncFileLogger::flush()
 {
-	std::lock_guard<std::mutex> guard_(mutex_);
-	if (logBufferPtr_->length() > 0)
 	{
-		swapBuffer();
-		cond_.notify_one();
+		std::lock_guard<std::mutex> lock(spillMutex_);
+		if (spillFp_)
+			fflush(spillFp_);
+	}
+	flushRequested_.store(true);
+	std::lock_guard<std::mutex> lock(mutex_);
+	cond_.notify_one();
+}
+
+void AsyncFileLogger::collectThreadBuffers()
+{
+	for (auto node = threadBuffers_.load(std::memory_order_acquire); node;
+		 node = node->next_)
+	{
+		// A thread which is appending holds its buffer, it is collected next
+		// time. The buffer is marked until it's published, the owner waits
+		// for it before it publishes a newer buffer.
+		auto& threadBuffer = node->buffer_->buffer_;
+		std::string* buf = threadBuffer.load(std::memory_order_relaxed);
+		if (!buf ||
+			!threadBuffer.compare_exchange_strong(buf,
+				&s_publishingBuffer,
+				std::memory_order_acquire,
+				std::memory_order_relaxed))
+			continue;
+		if (buf->empty())
+			recycleBuffer(buf);
+		else
+			publishBuffer(buf);
+		threadBuffer.store(nullptr, std::memory_order_release);
 	}
 }
 
-void AsyncFileLogger::writeLogToFile(const StringPtr buf)
+bool AsyncFileLogger::fillWriteRequest(IoRequest& request)
 {
-	if (!loggerFilePtr_)
+	size_t n = 0;
+	while (n < xMaxIovecs && writeBuffers_.dequeue(request.bufs_[n]))
+	{
+		++n;
+	}
+	if (n == 0)
+		return false;
+	request.type_ = IoRequest::xWrite;
+	request.bufCount_ = n;
+	request.firstVec_ = 0;
+	int count = 0;
+	uint64_t length = 0;
+	auto lost = lostCounter_.exchange(0, std::memory_order_relaxed);
+	if (lost > 0)
 	{
-		loggerFilePtr_ =
-			std::unique_ptr<LoggerFile>(new LoggerFile(filePath_,
-				fileBaseName_, fileExtName_, switchOnLimitOnly_, maxFiles_));
+		auto strlen = snprintf(request.lostMsg_,
+			sizeof(request.lostMsg_),
+			"%llu log information is lost\n",
+			static_cast<long long unsigned int>(lost));
+		request.vecs_[count].iov_base = request.lostMsg_;
+		request.vecs_[count].iov_len = strlen;
+		length += strlen;
+		++count;
 	}
-	loggerFilePtr_->writeLog(buf);
-	if (loggerFilePtr_->getLength() > sizeLimit_)
+	uint64_t bytes = 0;
+	for (size_t i = 0; i < n; ++i)
 	{
-		loggerFilePtr_->switchLog(true);
+		request.vecs_[count].iov_base = &(*request.bufs_[i])[0];
+		request.vecs_[count].iov_len = request.bufs_[i]->length();
+		bytes += request.bufs_[i]->length();
+		++count;
 	}
+	request.vecCount_ = count;
+	request.bytes_ = bytes;
+	request.length_ = length + bytes;
+	return true;
 }
 
-void AsyncFileLogger::logThreadFunc()
+void AsyncFileLogger::completeWrite(IoRequest& request)
 {
-#ifdef __linux__
-	prctl(PR_SET_NAEM, "AsyncFileLogger");
-#endif // __linux__
-	while (!stopFlag_)
+	for (size_t i = 0; i < request.bufCount_; ++i)
+	{
+		recycleBuffer(request.bufs_[i]);
+	}
+	request.bufCount_ = 0;
+	pendingBytes_.fetch_sub(request.bytes_);
+	// blockedThreads_ is increased before pendingBytes_ is checked by a
+	// blocked thread, see waitForRoom().
+	if (blockedThreads_.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(roomMutex_);
+		roomCond_.notify_all();
+	}
+}
+
+void AsyncFileLogger::reapCompletions(unsigned waitNum)
+{
+	if (waitNum > 0)
+	{
+		int ret = ring_->submit(waitNum);
+		if (ret < 0)
+		{
+			fprintf(stderr,
+				"Failed to wait for io_uring: %s\n",
+				strerror_tl(-ret));
+		}
+	}
+	uint64_t userData;
+	int result;
+	while (ring_->peekCompletion(userData, result))
 	{
+		auto request = reinterpret_cast<IoRequest*>(userData);
+		if (request->type_ == IoRequest::xWrite)
 		{
-			std::unique_lock<std::mutex> lock(mutex_);
-			while (writeBuffers_.size() == 0 && !stopFlag_)
+			if (result > 0 && static_cast<uint64_t>(result) < request->length_)
+			{
+				// write the rest at the end of the part written, so no hole
+				// is left in the file
+				auto iter = request->vecs_ + request->firstVec_;
+				skipWritten(iter,
+					request->vecCount_ - request->firstVec_,
+					static_cast<size_t>(result));
+				request->firstVec_ = static_cast<int>(iter - request->vecs_);
+				request->offset_ += static_cast<uint64_t>(result);
+				request->length_ -= static_cast<uint64_t>(result);
+				if (loggerFilePtr_ && loggerFilePtr_->resubmitLogs(*request))
+					continue;
+				LoggerFile::writeFullyAt(request->fd_,
+					iter,
+					request->vecCount_ - request->firstVec_,
+					request->offset_);
+			}
+			else if (result <= 0)
 			{
-				if (cond_.wait_for(lock, xLogFlushTimeout) ==
-					std::cv_status::timeout)
-				{
-					if (logBufferPtr_->length() > 0)
-					{
-						swapBuffer();
-					}
-					break;
-				}
+				// the file offset is already moved, a hole is left in the file
+				fprintf(stderr,
+					"Failed to write log file: %s\n",
+					result < 0 ? strerror_tl(-result) : "nothing written");
 			}
-			tmpBuffers_.swap(writeBuffers_);
+			completeWrite(*request);
 		}
-		while (!tmpBuffers_.empty())
+#ifndef _WIN32
+		else if (request->fd_ >= 0)
 		{
-			StringPtr tmpPtr = (StringPtr&&)tmpBuffers_.front();
-			tmpBuffers_.pop();
-			writeLogToFile(tmpPtr);
-			tmpPtr->clear();
+			::close(request->fd_);
+			request->fd_ = -1;
+		}
+#endif
+		freeIoRequests_.push_back(request);
+	}
+}
+
+bool AsyncFileLogger::writePendingBuffers()
+{
+	bool written = false;
+	IoRequest syncRequest;
+	for (;;)
+	{
+		IoRequest* request = &syncRequest;
+		if (ring_)
+		{
+			reapCompletions(ring_->inflight() >= xMaxInflightWrites ? 1 : 0);
+			if (freeIoRequests_.empty())
 			{
-				std::unique_lock<std::mutex> lock(mutex_);
-				nextBufferPtr_ = tmpPtr;
+				request = new IoRequest;
 			}
+			else
+			{
+				request = freeIoRequests_.back();
+				freeIoRequests_.pop_back();
+			}
+		}
+		if (!fillWriteRequest(*request))
+		{
+			if (request != &syncRequest)
+				freeIoRequests_.push_back(request);
+			break;
+		}
+		written = true;
+		if (!loggerFilePtr_)
+			createLoggerFile();
+		if (request == &syncRequest ||
+			!loggerFilePtr_->submitLogs(request->vecs_,
+				request->vecCount_,
+				request))
+		{
+			loggerFilePtr_->writeLogs(request->vecs_, request->vecCount_);
+			completeWrite(*request);
+			if (request != &syncRequest)
+				freeIoRequests_.push_back(request);
+		}
+		if (loggerFilePtr_->getLength() > sizeLimit_)
+		{
+			loggerFilePtr_->switchLog(true);
+		}
+	}
+	if (ring_)
+	{
+		int ret = ring_->submit();
+		if (ret < 0)
+		{
+			fprintf(stderr,
+				"Failed to submit to io_uring: %s\n",
+				strerror_tl(-ret));
+		}
+	}
+	if (written && loggerFilePtr_)
+		loggerFilePtr_->flush();
+	if (loggerFilePtr_ && loggerFilePtr_->generation() != fileGeneration_)
+	{
+		fileGeneration_ = loggerFilePtr_->generation();
+		if (newFileCallback_)
+		{
+			newFileCallback_();
+			// collect the logs of the callback from this thread's buffer
+			flushRequested_.store(true);
 		}
-		if (loggerFilePtr_)
-			loggerFilePtr_->flush();
+	}
+	return written;
+}
+
+bool AsyncFileLogger::setCompression(Compression compression, int level)
+{
+	switch (compression)
+	{
+#ifdef USE_ZLIB
+	case xGzip:
+#endif
+#ifdef USE_ZSTD
+	case xZstd:
+#endif
+	case xNoCompression:
+		compression_ = compression;
+		compressionLevel_ = level;
+		return true;
+	default:
+		return false;
+	}
+}
+
+void AsyncFileLogger::createLoggerFile()
+{
+	if (!housekeeper_)
+		housekeeper_.reset(new ConcurrentTaskQueue(1, "LogHousekeeper"));
+	loggerFilePtr_ = std::unique_ptr<LoggerFile>(new LoggerFile(filePath_,
+		fileBaseName_,
+		fileExtName_,
+		switchOnLimitOnly_,
+		maxFiles_,
+		directIo_,
+		ring_.get(),
+		housekeeper_.get(),
+		compression_,
+		compressionLevel_));
+}
+
+void AsyncFileLogger::logThreadFunc()
+{
+#ifdef __linux__
+	prctl(PR_SET_NAME, "AsyncFileLogger");
+#endif // __linux__
+	auto lastCollected = std::chrono::steady_clock::now();
+	while (!stopFlag_)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (flushRequested_.exchange(false) ||
+			now - lastCollected >= xLogFlushTimeout)
+		{
+			collectThreadBuffers();
+			lastCollected = now;
+		}
+		if (writePendingBuffers())
+			continue;
+		if (ring_ && ring_->inflight() > 0)
+		{
+			// the writes in flight hold buffers, wait for them instead of
+			// sleeping.
+			reapCompletions(1);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		writerSleeping_.store(true);
+		if (pendingBytes_.load() == 0 && !stopFlag_ && !flushRequested_)
+		{
+			cond_.wait_for(lock, xLogFlushTimeout);
+		}
+		writerSleeping_.store(false);
 	}
 }
 
 void AsyncFileLogger::startLogging()
 {
+	if (useIoUring_ && !ring_)
+	{
+		ring_.reset(new IoUring(xIoUringEntries));
+		if (!ring_->valid())
+		{
+			fprintf(stderr,
+				"io_uring is not available, log files are written with "
+				"write()\n");
+			ring_.reset();
+		}
+	}
 	threadPtr_ = std::unique_ptr<std::thread>(
 		new std::thread(std::bind(&AsyncFileLogger::logThreadFunc, this)));
 }
@@ -157,78 +793,552 @@ AsyncFileLogger::LoggerFile::LoggerFile(const std::string& filePath,
 	const std::string& fileBaseName,
 	const std::string& fileExtName,
 	bool switchOnLimitOnly,
-	size_t maxFiles)
+	size_t maxFiles,
+	bool directIo,
+	IoUring* ring,
+	TaskQueue* housekeeper,
+	Compression compression,
+	int compressionLevel)
 	: creationDate_(Date::date()),
+	fileFullName_(filePath + fileBaseName + fileExtName),
 	filePath_(filePath),
 	fileBaseName_(fileBaseName),
 	fileExtName_(fileExtName),
 	switchOnLimitOnly_(switchOnLimitOnly),
 	maxFiles_(maxFiles)
 {
+	housekeeper_ = housekeeper;
+	compression_ = compression;
+	compressionLevel_ = compressionLevel;
+#ifndef _WIN32
+	ring_ = ring;
+	nextFileName_ = filePath_ + fileBaseName_ + ".next" + fileExtName_;
+#else
+	(void)ring;
+#endif
+#if !defined(_WIN32) && defined(O_DIRECT)
+	wantDirectIo_ = directIo;
+#else
+	(void)directIo;
+#endif
 	open();
 
 	if (maxFiles_ > 0)
 	{
-		initFilenameQueue();
+		if (housekeeper_)
+			housekeeper_->runTaskInQueue([this]() { initFilenameQueue(); });
+		else
+			initFilenameQueue();
 	}
+#ifndef _WIN32
+	if (housekeeper_)
+		housekeeper_->runTaskInQueue([this]() { openNextFile(); });
+#endif
 }
 
 void AsyncFileLogger::LoggerFile::open()
 {
-	fileFullName_ = filePath_ + fileBaseName_ + fileExtName_;
-#ifndef _MSC_VER
+	++generation_;
+#ifndef _WIN32
+	fd_ = openFile(fileFullName_, offset_);
+	if (fd_ >= 0)
+		enableDirectIo();
+#elif !defined(_MSC_VER)
 	fp_ = fopen(fileFullName_.c_str(), "a");
 #else
 	auto wFullName{ utils::toNativePath(fileFullName_) };
 	fp_ = _wfsopen(wFullName.c_str(), L"a+", _SH_DENYWR);
-#endif // !_MSC_VER
+#endif  // _WIN32
+#ifdef _WIN32
 	if (fp_ == nullptr)
 	{
 		std::cout << strerror_tl(errno) << std::endl;
 	}
+#endif
+}
+
+#ifndef _WIN32
+int AsyncFileLogger::LoggerFile::openFile(const std::string& fileName,
+	uint64_t& offset)
+{
+	// with io_uring the writes carry their offsets, O_APPEND would ignore
+	// them.
+	int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+	if (!ring_)
+		flags |= O_APPEND;
+	int fd = ::open(fileName.c_str(), flags, 0644);
+	if (fd < 0)
+	{
+		std::cout << strerror_tl(errno) << std::endl;
+		return -1;
+	}
+	struct stat st;
+	offset = ::fstat(fd, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+	return fd;
+}
+
+void AsyncFileLogger::LoggerFile::enableDirectIo()
+{
+	directIo_ = false;
+#ifdef O_DIRECT
+	// O_DIRECT writes must start at an aligned offset
+	if (wantDirectIo_ && offset_ % xDirectIoAlignment == 0)
+	{
+		int flags = ::fcntl(fd_, F_GETFL);
+		if (flags >= 0 && ::fcntl(fd_, F_SETFL, flags | O_DIRECT) == 0)
+		{
+			if (!directBuf_ &&
+				posix_memalign(reinterpret_cast<void**>(&directBuf_),
+					xDirectIoAlignment,
+					xDirectBufferSize) != 0)
+			{
+				directBuf_ = nullptr;
+				::fcntl(fd_, F_SETFL, flags);
+			}
+			else
+			{
+				directIo_ = true;
+			}
+		}
+		else
+		{
+			fprintf(stderr,
+				"O_DIRECT is not supported for %s: %s\n",
+				fileFullName_.c_str(),
+				strerror_tl(errno));
+		}
+	}
+#endif  // O_DIRECT
+}
+
+void AsyncFileLogger::LoggerFile::openNextFile()
+{
+	uint64_t offset = 0;
+	// a file left by a crash is reused, its logs are kept.
+	int fd = openFile(nextFileName_, offset);
+	std::lock_guard<std::mutex> lock(nextMutex_);
+	nextFd_ = fd;
+	nextOffset_ = offset;
+	nextFailed_ = fd < 0;
+}
+
+void AsyncFileLogger::LoggerFile::closeNextFile()
+{
+	std::lock_guard<std::mutex> lock(nextMutex_);
+	if (nextFd_ < 0)
+		return;
+	::close(nextFd_);
+	nextFd_ = -1;
+	if (nextOffset_ == 0)
+		::unlink(nextFileName_.c_str());
 }
 
+bool AsyncFileLogger::LoggerFile::swapToNextFile()
+{
+	int fd;
+	uint64_t offset;
+	{
+		std::lock_guard<std::mutex> lock(nextMutex_);
+		if (nextFd_ < 0)
+		{
+			// keep writing the current file until the next one is ready
+			if (nextFailed_)
+			{
+				nextFailed_ = false;
+				housekeeper_->runTaskInQueue([this]() { openNextFile(); });
+			}
+			return false;
+		}
+		fd = nextFd_;
+		offset = nextOffset_;
+		nextFd_ = -1;
+	}
+	if (directIo_)
+		writeDirectBlocks(true);
+	int oldFd = fd_;
+	fd_ = fd;
+	offset_ = offset;
+	++generation_;
+	enableDirectIo();
+	if (ring_ && closeThroughRing(oldFd))
+		oldFd = -1;
+	std::string archivedName = archivedFileName();
+	housekeeper_->runTaskInQueue([this, oldFd, archivedName]() {
+		if (oldFd >= 0)
+			::close(oldFd);
+		// On failure the writer keeps the file it's writing, which is still
+		// named nextFileName_, and no next file is opened on that path.
+		if (::rename(fileFullName_.c_str(), archivedName.c_str()) != 0)
+		{
+			fprintf(stderr,
+				"Failed to rotate log file %s: %s\n",
+				fileFullName_.c_str(),
+				strerror_tl(errno));
+			return;
+		}
+		if (::rename(nextFileName_.c_str(), fileFullName_.c_str()) != 0)
+		{
+			fprintf(stderr,
+				"Failed to rotate log file %s: %s\n",
+				fileFullName_.c_str(),
+				strerror_tl(errno));
+			housekeeper_->runTaskInQueue(
+				[this, archivedName]() { archiveFile(archivedName); });
+			return;
+		}
+		// the next file is ready before the slow compression of the rotated
+		// one, so the next rotation isn't delayed by it
+		openNextFile();
+		housekeeper_->runTaskInQueue(
+			[this, archivedName]() { archiveFile(archivedName); });
+	});
+	return true;
+}
+#endif  // !_WIN32
+
 uint64_t AsyncFileLogger::LoggerFile::fileSeq_{ 0 };
-void AsyncFileLogger::LoggerFile::writeLog(const StringPtr buf)
+void AsyncFileLogger::LoggerFile::writeLog(const char* data, size_t len)
+{
+	struct iovec vec;
+	vec.iov_base = const_cast<char*>(data);
+	vec.iov_len = len;
+	writeLogs(&vec, 1);
+}
+
+void AsyncFileLogger::LoggerFile::writeLogs(const struct iovec* vecs,
+	int count)
 {
+#ifndef _WIN32
+	if (fd_ < 0)
+		return;
+	if (directIo_)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			appendDirect(static_cast<const char*>(vecs[i].iov_base),
+				vecs[i].iov_len);
+		}
+		return;
+	}
+	writeFully(vecs, count);
+#else
 	if (fp_)
 	{
-		fwrite(buf->c_str(), 1, buf->length(), fp_);
+		for (int i = 0; i < count; ++i)
+		{
+			fwrite(vecs[i].iov_base, 1, vecs[i].iov_len, fp_);
+		}
+	}
+#endif
+}
+
+bool AsyncFileLogger::LoggerFile::submitLogs(const struct iovec* vecs,
+	int count,
+	IoRequest* request)
+{
+#ifndef _WIN32
+	// the O_DIRECT buffer is written synchronously
+	if (!ring_ || fd_ < 0 || directIo_)
+		return false;
+	if (!ring_->prepareWritev(fd_,
+			vecs,
+			static_cast<unsigned>(count),
+			offset_,
+			reinterpret_cast<uint64_t>(request)))
+		return false;
+	request->fd_ = fd_;
+	request->offset_ = offset_;
+	offset_ += request->length_;
+	return true;
+#else
+	(void)vecs;
+	(void)count;
+	(void)request;
+	return false;
+#endif
+}
+
+bool AsyncFileLogger::LoggerFile::resubmitLogs(IoRequest& request)
+{
+#ifndef _WIN32
+	// the request of an older file is not resubmitted, the file is closed
+	// after its fsync
+	if (!ring_ || fd_ < 0 || request.fd_ != fd_)
+		return false;
+	return ring_->prepareWritev(fd_,
+		request.vecs_ + request.firstVec_,
+		static_cast<unsigned>(request.vecCount_ - request.firstVec_),
+		request.offset_,
+		reinterpret_cast<uint64_t>(&request));
+#else
+	(void)request;
+	return false;
+#endif
+}
+
+void AsyncFileLogger::LoggerFile::writeFullyAt(int fd,
+	struct iovec* vecs,
+	int count,
+	uint64_t offset)
+{
+#ifndef _WIN32
+	while (count > 0)
+	{
+		ssize_t n = ::pwritev(fd, vecs, count, static_cast<off_t>(offset));
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr,
+				"Failed to write log file: %s\n",
+				strerror_tl(errno));
+			return;
+		}
+		offset += static_cast<uint64_t>(n);
+		count = skipWritten(vecs, count, static_cast<size_t>(n));
+	}
+	// The fsync queued on rotation may be done already, the file is closed
+	// after its completion, which is reaped after this write.
+	if (::fsync(fd) != 0)
+	{
+		fprintf(stderr,
+			"Failed to sync log file: %s\n",
+			strerror_tl(errno));
+	}
+#else
+	(void)fd;
+	(void)vecs;
+	(void)count;
+	(void)offset;
+#endif
+}
+
+#ifndef _WIN32
+void AsyncFileLogger::LoggerFile::writeFully(const struct iovec* vecs,
+	int count)
+{
+	struct iovec remaining[xMaxIovecs + 1];
+	assert(static_cast<size_t>(count) <= xMaxIovecs + 1);
+	memcpy(remaining, vecs, sizeof(struct iovec) * count);
+	struct iovec* iter = remaining;
+	while (count > 0)
+	{
+#ifdef XIAO_HAS_IO_URING
+		ssize_t n = ring_ ? ::pwritev(fd_, iter, count, offset_)
+						  : ::writev(fd_, iter, count);
+#else
+		ssize_t n = ::writev(fd_, iter, count);
+#endif
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr,
+				"Failed to write log file %s: %s\n",
+				fileFullName_.c_str(),
+				strerror_tl(errno));
+			return;
+		}
+		offset_ += static_cast<uint64_t>(n);
+		count = skipWritten(iter, count, static_cast<size_t>(n));
+	}
+}
+
+void AsyncFileLogger::LoggerFile::appendDirect(const char* data, size_t len)
+{
+	while (len > 0)
+	{
+		size_t n = std::min(len, xDirectBufferSize - directLen_);
+		memcpy(directBuf_ + directLen_, data, n);
+		directLen_ += n;
+		data += n;
+		len -= n;
+		if (directLen_ == xDirectBufferSize)
+			writeDirectBlocks(false);
+	}
+}
+
+void AsyncFileLogger::LoggerFile::writeDirectBlocks(bool all)
+{
+	size_t blocks = directLen_ / xDirectIoAlignment * xDirectIoAlignment;
+	if (blocks > 0)
+	{
+		struct iovec vec;
+		vec.iov_base = directBuf_;
+		vec.iov_len = blocks;
+		writeFully(&vec, 1);
+		memmove(directBuf_, directBuf_ + blocks, directLen_ - blocks);
+		directLen_ -= blocks;
+	}
+	if (all && directLen_ > 0)
+	{
+#ifdef O_DIRECT
+		// the tail isn't a whole block, write it without O_DIRECT. The file
+		// isn't aligned any more, so it is only done when closing the file.
+		int flags = ::fcntl(fd_, F_GETFL);
+		if (flags >= 0)
+			::fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+#endif
+		directIo_ = false;
+		struct iovec vec;
+		vec.iov_base = directBuf_;
+		vec.iov_len = directLen_;
+		writeFully(&vec, 1);
+		directLen_ = 0;
 	}
 }
+#endif  // !_WIN32
 
 void AsyncFileLogger::LoggerFile::flush()
 {
+#ifndef _WIN32
+	// write() has passed the data to the kernel, only whole blocks in the
+	// O_DIRECT buffer are pending.
+	if (directIo_)
+		writeDirectBlocks(false);
+#else
 	if (fp_)
 	{
 		fflush(fp_);
 	}
+#endif
 }
 
 uint64_t AsyncFileLogger::LoggerFile::getLength()
 {
+#ifndef _WIN32
+	return offset_ + directLen_;
+#else
 	if (fp_)
 		return ftell(fp_);
 	return 0;
+#endif
 }
 
-void AsyncFileLogger::LoggerFile::switchLog(bool openNewOne)
+#ifndef _WIN32
+bool AsyncFileLogger::LoggerFile::closeThroughRing(int fd)
+{
+#ifdef XIAO_HAS_IO_URING
+	// Sync the file after the writes in flight and close it when the sync
+	// completes, the writer thread goes on with the new file.
+	auto request = new IoRequest;
+	request->type_ = IoRequest::xSync;
+	request->fd_ = fd;
+	if (ring_->prepareFsync(fd,
+			reinterpret_cast<uint64_t>(request),
+			IOSQE_IO_DRAIN))
+	{
+		ring_->submit();
+		return true;
+	}
+	delete request;
+#else
+	(void)fd;
+#endif
+	return false;
+}
+#endif  // !_WIN32
+
+void AsyncFileLogger::LoggerFile::close()
 {
+#ifndef _WIN32
+	if (fd_ >= 0)
+	{
+		if (directIo_)
+			writeDirectBlocks(true);
+		if (!ring_ || !closeThroughRing(fd_))
+			::close(fd_);
+		fd_ = -1;
+		offset_ = 0;
+	}
+#else
 	if (fp_)
 	{
 		fclose(fp_);
 		fp_ = nullptr;
+	}
+#endif
+}
 
-		char seq[12];
-		snprintf(seq,
-			sizeof(seq),
-			".%06llu",
-			static_cast<long long unsigned int>(fileSeq_ % 1000000));
-		++fileSeq_;
-		std::string newName =
-			filePath_ + fileBaseName_ + "." +
-			creationDate_.toCustomedFormattedString("%y%m%d-%H%M%S") +
-			std::string(seq) + fileExtName_;
+std::string AsyncFileLogger::LoggerFile::archivedFileName()
+{
+	char seq[12];
+	snprintf(seq,
+		sizeof(seq),
+		".%06llu",
+		static_cast<long long unsigned int>(fileSeq_ % 1000000));
+	++fileSeq_;
+	return filePath_ + fileBaseName_ + "." +
+		creationDate_.toCustomedFormattedString("%y%m%d-%H%M%S") +
+		std::string(seq) + fileExtName_;
+}
+
+void AsyncFileLogger::LoggerFile::archiveFile(const std::string& archivedName)
+{
+	std::string fileName = archivedName;
+	if (compression_ != xNoCompression)
+		fileName = compressFile(archivedName);
+	if (maxFiles_ > 0)
+	{
+		filenameQueue_.push_back(fileName);
+		if (filenameQueue_.size() > maxFiles_)
+		{
+			deleteOldFiles();
+		}
+	}
+}
+
+std::string AsyncFileLogger::LoggerFile::compressFile(
+	const std::string& fileName)
+{
+	std::string compressedName = fileName + compressionSuffix(compression_);
+	// the temporary file isn't counted by initFilenameQueue() after a crash
+	std::string tmpName = compressedName + ".tmp";
+	bool ok = false;
+	FILE* in = fopen(fileName.c_str(), "rb");
+	if (in)
+	{
+		switch (compression_)
+		{
+#ifdef USE_ZLIB
+		case xGzip:
+			ok = gzipFile(in, tmpName, compressionLevel_);
+			break;
+#endif
+#ifdef USE_ZSTD
+		case xZstd:
+			ok = zstdFile(in, tmpName, compressionLevel_);
+			break;
+#endif
+		default:
+			break;
+		}
+		fclose(in);
+	}
+	if (!ok || rename(tmpName.c_str(), compressedName.c_str()) != 0)
+	{
+		fprintf(stderr, "Failed to compress log file %s\n", fileName.c_str());
+		remove(tmpName.c_str());
+		return fileName;
+	}
+	remove(fileName.c_str());
+	return compressedName;
+}
+
+void AsyncFileLogger::LoggerFile::switchLog(bool openNewOne)
+{
+	if (*this)
+	{
+#ifndef _WIN32
+		if (openNewOne && housekeeper_)
+		{
+			swapToNextFile();
+			return;
+		}
+#endif
+		close();
+
+		std::string newName = archivedFileName();
 #if !defined(_WIN32) || defined(__MINGW32__)
 		rename(fileFullName_.c_str(), newName.c_str());
 #else
@@ -236,14 +1346,11 @@ void AsyncFileLogger::LoggerFile::switchLog(bool openNewOne)
 		auto wNewName{ utils::toNativePath(newName) };
 		_wrename(wFullName.c_str(), wNewName.c_str());
 #endif
-		if (maxFiles_ > 0)
-		{
-			filenameQueue_.push_back(newName);
-			if (filenameQueue_.size() > maxFiles_)
-			{
-				deleteOldFiles();
-			}
-		}
+		if (housekeeper_)
+			housekeeper_->runTaskInQueue(
+				[this, newName]() { archiveFile(newName); });
+		else
+			archiveFile(newName);
 		if (openNewOne)
 			open();
 	}
@@ -251,10 +1358,23 @@ void AsyncFileLogger::LoggerFile::switchLog(bool openNewOne)
 
 AsyncFileLogger::LoggerFile::~LoggerFile()
 {
+	if (housekeeper_)
+	{
+		// wait for the rotation in progress
+		housekeeper_->submit([]() {}).wait();
+	}
 	if (!switchOnLimitOnly_)
 		switchLog(false);
-	if (fp_)
-		fclose(fp_);
+	close();
+#ifndef _WIN32
+	closeNextFile();
+	free(directBuf_);
+#endif
+	if (housekeeper_)
+	{
+		// the last file is compressed and the old ones are deleted
+		housekeeper_->submit([]() {}).wait();
+	}
 }
 
 void AsyncFileLogger::LoggerFile::initFilenameQueue()
@@ -281,11 +1401,12 @@ void AsyncFileLogger::LoggerFile::initFilenameQueue()
 	while ((dirp = readdir(dp)) != nullptr)
 	{
 		std::string name = dirp->d_name;
-		// <base>.yymmdd-hhmmss.000000<ext>
+		// <base>.yymmdd-hhmmss.000000<ext>[.gz|.zst]
 		// NOTE: magic number 21: the length of middle part of generated name
-		if (name.size() != fileBaseName_.size() + 21 + fileExtName_.size() ||
+		size_t len = rawNameLength(name);
+		if (len != fileBaseName_.size() + 21 + fileExtName_.size() ||
 			name.compare(0, fileBaseName_.size(), fileBaseName_) != 0 ||
-			name.compare(name.size() - fileExtName_.size(),
+			name.compare(len - fileExtName_.size(),
 				fileExtName_.size(),
 				fileExtName_) != 0)
 		{
@@ -347,19 +1468,3 @@ void AsyncFileLogger::LoggerFile::deleteOldFiles()
 		}
 	}
 }
-
-void AsyncFileLogger::swapBuffer()
-{
-	writeBuffers_.push(logBufferPtr_);
-	if (nextBufferPtr_)
-	{
-		logBufferPtr_ = nextBufferPtr_;
-		nextBufferPtr_.reset();
-		logBufferPtr_->clear();
-	}
-	else
-	{
-		logBufferPtr_ = std::make_shared<std::string>();
-		logBufferPtr_->reserve(xMemBufferSize);
-	}
-}
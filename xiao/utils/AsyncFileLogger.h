@@ -9,33 +9,95 @@
 #pragma once
 
 #include <xiao/utils/NonCopyable.h>
+#include <xiao/utils/LockFreeQueue.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <deque>
 #include <queue>
 #include <mutex>
+#include <thread>
 #include <condition_variable>
 #include <xiao/utils/Date.h>
+#include <xiao/utils/Logger.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#else
+#include <xiao/utils/WindowsSupport.h>
+#endif
 
 BEGIN_NAMESPACE(xiao)
 
+class IoUring;
+class TaskQueue;
+
 using StringPtr = std::shared_ptr<std::string>;
 using StringPtrQueue = std::queue<StringPtr>;
 
 /**
  * @brief This class implements utility functions for writing logs to files asynchronously.
+ * Every thread appends its logs to its own staging buffer without locking, full
+ * buffers are handed to the writer thread through a lock-free queue, and the
+ * writer collects the partially filled ones periodically and on flush(). The
+ * order of the logs of one thread is preserved.
  */
 
 class XIAO_EXPORT AsyncFileLogger : NonCopyable
 {
 public:
 	/**
-	 * @brief Write the message to the log file.
+	 * @brief The policies applied when the logs buffered in memory reach the
+	 * limit (see setMaxBufferedBytes()).
+	 */
+	enum BackpressurePolicy
+	{
+		// Drop the new logs.
+		xDrop = 0,
+		// Block the logging thread until there is room or the timeout
+		// expires, the log is dropped on timeout.
+		xBlockWithTimeout,
+		// Drop the logs of lower severity earlier: trace and debug logs are
+		// dropped when the buffers are half full, info logs at 3/4 and warn
+		// logs at 7/8, error and fatal logs only when they are full.
+		xDropLowSeverity,
+		// Write the logs synchronously to a secondary file.
+		xSpillToFile
+	};
+
+	/**
+	 * @brief The compression applied to the rotated log files.
+	 */
+	enum Compression
+	{
+		xNoCompression = 0,
+		// <name>.gz, needs zlib
+		xGzip,
+		// <name>.zst, needs libzstd
+		xZstd
+	};
+
+	struct BackpressureStats
+	{
+		uint64_t droppedLines_{ 0 };
+		uint64_t droppedBytes_{ 0 };
+		uint64_t spilledBytes_{ 0 };
+		// the total time the logging threads are blocked
+		std::chrono::microseconds stallTime_{ 0 };
+	};
+
+	/**
+	 * @brief Write the message to the log file. The severity used by the
+	 * backpressure policy is Logger::outputLevel().
 	 * 
 	 * \param msg
 	 * \param len
 	 */
 	void output(const char* msg, const uint64_t len);
 
+	void output(const char* msg, const uint64_t len, Logger::LogLevel level);
+
 	/**
 	 * @brief Flush data from memory buffer to the log file.
 	 * 
@@ -48,6 +110,17 @@ public:
 	 */
 	void startLogging();
 
+	/**
+	 * @brief Set the function called by the writer thread when a new log
+	 * file is opened, the logs it writes go to the new file, e.g. the site
+	 * records of the binary logs (see BinaryLogger::attach()). Must be
+	 * called before startLogging().
+	 */
+	void setNewFileCallback(std::function<void()> callback)
+	{
+		newFileCallback_ = std::move(callback);
+	}
+
 	void setFileSizeLimit(uint64_t limit)
 	{
 		sizeLimit_ = limit;
@@ -58,6 +131,84 @@ public:
 		maxFiles_ = maxFiles;
 	}
 
+	/**
+	 * @brief Compress every rotated file in the background, the raw file is
+	 * removed when its compressed copy is complete. The compressed files are
+	 * counted by setMaxFiles(). Must be called before startLogging().
+	 *
+	 * \param level The compression level, a negative value means the default
+	 * level of the library.
+	 * \return false if the library isn't compiled in.
+	 */
+	bool setCompression(Compression compression, int level = -1);
+
+	void setBackpressurePolicy(BackpressurePolicy policy)
+	{
+		policy_ = policy;
+	}
+
+	/**
+	 * @brief Set how long a logging thread is blocked at most with the
+	 * xBlockWithTimeout policy.
+	 */
+	void setBlockTimeout(std::chrono::milliseconds timeout)
+	{
+		blockTimeout_ = timeout;
+	}
+
+	/**
+	 * @brief Set the full path of the file used by the xSpillToFile policy,
+	 * the default is <path><baseName>.spill<extName>.
+	 */
+	void setSpillFileName(const std::string& fullName)
+	{
+		spillFileName_ = fullName;
+	}
+
+	/**
+	 * @brief Set the size of the staging buffer of every logging thread, the
+	 * buffers already in use keep their size.
+	 */
+	void setBufferSize(size_t size)
+	{
+		bufferSize_ = size;
+	}
+
+	/**
+	 * @brief Set the max bytes of logs waiting in memory for the writer thread
+	 * before the backpressure policy applies.
+	 */
+	void setMaxBufferedBytes(uint64_t bytes)
+	{
+		maxBufferedBytes_ = bytes;
+	}
+
+	BackpressureStats getBackpressureStats() const;
+
+	/**
+	 * @brief Write the log files with O_DIRECT, bypassing the page cache. The
+	 * data is staged in an aligned buffer and only whole blocks are written,
+	 * so up to one block of logs stays in memory until the file is closed.
+	 * It falls back to buffered writes if the file system doesn't support
+	 * O_DIRECT. Only available on Linux, must be called before the first log.
+	 */
+	void setDirectIo(bool flag = true)
+	{
+		directIo_ = flag;
+	}
+
+	/**
+	 * @brief Submit the writes and the fsync on rotation through io_uring, so
+	 * several buffers are in flight at once and the writer thread doesn't
+	 * wait for each of them. It falls back to write() when the kernel lacks
+	 * io_uring. Only available on Linux, must be called before
+	 * startLogging().
+	 */
+	void setIoUring(bool flag = true)
+	{
+		useIoUring_ = flag;
+	}
+
 	void setSwitchOnLimitOnly(bool flag = true)
 	{
 		switchOnLimitOnly_ = flag;
@@ -80,6 +231,7 @@ public:
 	AsyncFileLogger();
 
 protected:
+	// Only used by the writer thread to sleep when there is nothing to write.
 	std::mutex mutex_;
 	std::condition_variable cond_;
 	uint64_t sizeLimit_{ 20 * 1024 * 1024 };
@@ -88,15 +240,66 @@ protected:
 	std::string filePath_{ "./" };
 	std::string fileBaseName_{ "xiao" };
 	std::string fileExtName_{ ".log" };
-	StringPtr logBufferPtr_;
-	StringPtr nextBufferPtr_;
-	bool stopFlag_{ false };
+	std::atomic<bool> stopFlag_{ false };
 	std::unique_ptr<std::thread> threadPtr_;
-	StringPtrQueue writeBuffers_;
-	StringPtrQueue tmpBuffers_;
-	void writeLogToFile(const StringPtr buf);
+	bool directIo_{ false };
+	Compression compression_{ xNoCompression };
+	int compressionLevel_{ -1 };
+	// Rotates and deletes the log files off the writer thread.
+	std::unique_ptr<TaskQueue> housekeeper_;
+	void createLoggerFile();
+
+	// io_uring mode
+	struct IoRequest;
+	bool useIoUring_{ false };
+	std::unique_ptr<IoUring> ring_;
+	std::vector<IoRequest*> freeIoRequests_;
+	bool fillWriteRequest(IoRequest& request);
+	void completeWrite(IoRequest& request);
+	void reapCompletions(unsigned waitNum);
 	void logThreadFunc();
 
+	struct ThreadBuffer
+	{
+		~ThreadBuffer()
+		{
+			delete buffer_.load();
+		}
+		// The staging buffer of the owner thread. The owner exchanges it with
+		// nullptr while appending, so the writer can only take it between
+		// two appends. The writer marks it while publishing it, see
+		// collectThreadBuffers().
+		std::atomic<std::string*> buffer_{ nullptr };
+		// false when the owner thread has exited, the buffer is then reused
+		// by a new thread.
+		std::atomic<bool> inUse_{ true };
+	};
+	using ThreadBufferPtr = std::shared_ptr<ThreadBuffer>;
+	struct ThreadBufferNode
+	{
+		ThreadBufferPtr buffer_;
+		ThreadBufferNode* next_{ nullptr };
+	};
+	const uint64_t loggerId_;
+	std::atomic<ThreadBufferNode*> threadBuffers_{ nullptr };
+	ThreadBuffer* getThreadBuffer();
+	void collectThreadBuffers();
+
+	std::string* newBuffer(size_t len);
+	void recycleBuffer(std::string* buf);
+	void publishBuffer(std::string* buf);
+	bool writePendingBuffers();
+
+	MpscQueue<std::string*> writeBuffers_;
+	MpmcQueue<std::string*> freeBuffers_;
+	// the bytes published to writeBuffers_ and not written yet
+	std::atomic<uint64_t> pendingBytes_{ 0 };
+	std::atomic<bool> writerSleeping_{ false };
+	std::atomic<bool> flushRequested_{ false };
+	std::function<void()> newFileCallback_;
+	// the generation of the file the callback was called for
+	uint64_t fileGeneration_{ 0 };
+
 	class LoggerFile : NonCopyable
 	{
 	public:
@@ -104,29 +307,109 @@ protected:
 			const std::string& fileBaseName,
 			const std::string& fileExtName,
 			bool switchOnLimitOnly = false,
-			size_t maxFiles = 0);
+			size_t maxFiles = 0,
+			bool directIo = false,
+			IoUring* ring = nullptr,
+			TaskQueue* housekeeper = nullptr,
+			Compression compression = xNoCompression,
+			int compressionLevel = -1);
 		~LoggerFile();
-		void writeLog(const StringPtr buf);
+		void writeLog(const char* data, size_t len);
+		/**
+		 * @brief Write the buffers with one writev() call when possible.
+		 */
+		void writeLogs(const struct iovec* vecs, int count);
+		/**
+		 * @brief Queue the buffers to io_uring at the end of the file.
+		 *
+		 * \return false if they can't be queued, writeLogs() should be used.
+		 */
+		bool submitLogs(const struct iovec* vecs, int count, IoRequest* request);
+		/**
+		 * @brief Queue the rest of a request after a short write.
+		 *
+		 * \return false if the request is not of the current file or can't
+		 * be queued, writeFullyAt() should be used.
+		 */
+		bool resubmitLogs(IoRequest& request);
+		/**
+		 * @brief Write the buffers at the offset and sync the file.
+		 */
+		static void writeFullyAt(int fd,
+			struct iovec* vecs,
+			int count,
+			uint64_t offset);
 		void open();
 		void switchLog(bool openNewOne);
 		uint64_t getLength();
 		explicit operator bool() const
 		{
+#ifndef _WIN32
+			return fd_ >= 0;
+#else
 			return fp_ != nullptr;
+#endif
 		}
 		void flush();
+		// Increased whenever a new file is opened.
+		uint64_t generation() const
+		{
+			return generation_;
+		}
 
 	protected:
 		void initFilenameQueue();
 		void deleteOldFiles();
+		void close();
+		std::string archivedFileName();
+		void archiveFile(const std::string& archivedName);
+		std::string compressFile(const std::string& fileName);
+		Compression compression_{ xNoCompression };
+		int compressionLevel_{ -1 };
+
+		// With a housekeeper, the next file is opened in advance and the
+		// writer swaps to it. Closing, renaming and deleting the old files
+		// is done by the housekeeper.
+		TaskQueue* housekeeper_{ nullptr };
+		bool swapToNextFile();
 
+#ifndef _WIN32
+		// The file is opened with O_APPEND and written with write()/writev(),
+		// the length is tracked in memory.
+		int fd_{ -1 };
+		uint64_t offset_{ 0 };
+		int openFile(const std::string& fileName, uint64_t& offset);
+		void enableDirectIo();
+		// The file opened by the housekeeper, guarded by nextMutex_.
+		std::mutex nextMutex_;
+		std::string nextFileName_;
+		int nextFd_{ -1 };
+		uint64_t nextOffset_{ 0 };
+		bool nextFailed_{ false };
+		void openNextFile();
+		void closeNextFile();
+		// With io_uring the file is written at explicit offsets, several
+		// writes can be in flight.
+		IoUring* ring_{ nullptr };
+		bool closeThroughRing(int fd);
+		void writeFully(const struct iovec* vecs, int count);
+		// O_DIRECT mode, directIo_ is false if the file system rejects it.
+		bool wantDirectIo_{ false };
+		bool directIo_{ false };
+		char* directBuf_{ nullptr };
+		size_t directLen_{ 0 };
+		void appendDirect(const char* data, size_t len);
+		void writeDirectBlocks(bool all);
+#else
 		FILE* fp_{ nullptr };
+#endif
 		Date creationDate_;
 		std::string fileFullName_;
 		std::string filePath_;
 		std::string fileBaseName_;
 		std::string fileExtName_;
 		static uint64_t fileSeq_;
+		uint64_t generation_{ 0 };
 		bool switchOnLimitOnly_{ false };
 
 		size_t maxFiles_{ 0 };
@@ -134,8 +417,28 @@ protected:
 	};
 	std::unique_ptr<LoggerFile> loggerFilePtr_;
 
-	uint64_t lostCounter_{ 0 };
-	void swapBuffer();
+	std::atomic<uint64_t> lostCounter_{ 0 };
+
+	// backpressure
+	bool admit(const char* msg, const uint64_t len, Logger::LogLevel level);
+	bool waitForRoom(const uint64_t len);
+	bool spill(const char* msg, const uint64_t len);
+	std::atomic<BackpressurePolicy> policy_{ xDrop };
+	std::atomic<std::chrono::milliseconds> blockTimeout_{
+		std::chrono::milliseconds(100)
+	};
+	std::atomic<size_t> bufferSize_;
+	std::atomic<uint64_t> maxBufferedBytes_;
+	std::mutex roomMutex_;
+	std::condition_variable roomCond_;
+	std::atomic<size_t> blockedThreads_{ 0 };
+	std::mutex spillMutex_;
+	std::string spillFileName_;
+	FILE* spillFp_{ nullptr };
+	std::atomic<uint64_t> droppedLines_{ 0 };
+	std::atomic<uint64_t> droppedBytes_{ 0 };
+	std::atomic<uint64_t> spilledBytes_{ 0 };
+	std::atomic<uint64_t> stallTimeUs_{ 0 };
 };
 
 END_NAMESPACE(xiao)
@@ -0,0 +1,161 @@
+/**
+ * @file   BinaryLog.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/utils/BinaryLog.h>
+#include <xiao/utils/AsyncFileLogger.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+struct RegisteredSite
+{
+	const BinaryLogSite* site_;
+	// the indexes the site record is written to
+	std::vector<int> indexes_;
+	std::string format_;
+	std::string argTypes_;
+};
+
+struct SiteRegistry
+{
+	std::mutex mutex_;
+	std::vector<RegisteredSite> sites_;
+};
+
+static SiteRegistry& siteRegistry()
+{
+	static SiteRegistry registry;
+	return registry;
+}
+
+template <typename T>
+static void appendValue(std::string& buf, T value)
+{
+	buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void appendHeader(char* buf, BinaryRecordType type, size_t length)
+{
+	memcpy(buf, &xBinaryLogMagic, sizeof(xBinaryLogMagic));
+	buf[2] = static_cast<char>(type);
+	buf[3] = 0;
+	auto len = static_cast<uint32_t>(length);
+	memcpy(buf + 4, &len, sizeof(len));
+}
+
+static std::string encodeSiteRecord(const RegisteredSite& registered,
+	uint32_t id)
+{
+	const char* file = registered.site_->file_;
+#ifndef _MSC_VER
+	const char* slash = strrchr(file, '/');
+#else
+	const char* slash = strrchr(file, '\\');
+#endif
+	if (slash)
+		file = slash + 1;
+	auto fileLength = static_cast<uint16_t>(strlen(file));
+	auto formatLength = static_cast<uint16_t>(
+		std::min<size_t>(registered.format_.size(), UINT16_MAX));
+
+	std::string record(xBinaryHeaderSize, '\0');
+	appendValue(record, id);
+	appendValue(record, static_cast<uint8_t>(registered.site_->level_));
+	appendValue(record, static_cast<int32_t>(registered.site_->line_));
+	appendValue(record, static_cast<uint8_t>(registered.argTypes_.size()));
+	record.append(registered.argTypes_);
+	appendValue(record, fileLength);
+	record.append(file, fileLength);
+	appendValue(record, formatLength);
+	record.append(registered.format_.data(), formatLength);
+	appendHeader(&record[0], xBinarySiteRecord, record.size());
+	return record;
+}
+END_NAMESPACE(xiao)
+
+uint32_t BinaryLogger::registerSite(BinaryLogSite& site,
+	int index,
+	const char* format,
+	const char* argTypes,
+	size_t argCount)
+{
+	auto& registry = siteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	uint32_t id = site.id_.load(std::memory_order_relaxed);
+	if (id == 0)
+	{
+		registry.sites_.push_back(
+			{ &site, {}, format, std::string(argTypes, argCount) });
+		id = static_cast<uint32_t>(registry.sites_.size());
+	}
+	auto& registered = registry.sites_[id - 1];
+	if (std::find(registered.indexes_.begin(),
+			registered.indexes_.end(),
+			index) == registered.indexes_.end())
+	{
+		registered.indexes_.push_back(index);
+		// The site record is written by this thread before its first entry
+		// of the index, entries of other threads may come earlier, see
+		// xiao_log_decoder.
+		auto record = encodeSiteRecord(registered, id);
+		Logger::output(index, site.level_, record.data(), record.size());
+	}
+	site.index_.store(index, std::memory_order_release);
+	site.id_.store(id, std::memory_order_release);
+	return id;
+}
+
+void BinaryLogger::writeEntry(const BinaryLogSite& site,
+	int index,
+	uint32_t id,
+	char* buf,
+	size_t len)
+{
+	appendHeader(buf, xBinaryEntryRecord, len);
+	char* p = buf + xBinaryHeaderSize;
+	memcpy(p, &id, sizeof(id));
+	int64_t now = Date::now().microSecondsSinceEpoch();
+	memcpy(p + 4, &now, sizeof(now));
+	uint64_t tid = Logger::threadId();
+	memcpy(p + 12, &tid, sizeof(tid));
+	Logger::output(index, site.level_, buf, len);
+}
+
+void BinaryLogger::writeSites(int index)
+{
+	auto& registry = siteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	for (size_t i = 0; i < registry.sites_.size(); ++i)
+	{
+		auto& registered = registry.sites_[i];
+		if (std::find(registered.indexes_.begin(),
+				registered.indexes_.end(),
+				index) == registered.indexes_.end())
+			continue;
+		auto record =
+			encodeSiteRecord(registered, static_cast<uint32_t>(i + 1));
+		Logger::output(index,
+			registered.site_->level_,
+			record.data(),
+			record.size());
+	}
+}
+
+void BinaryLogger::attach(AsyncFileLogger& logger, int index)
+{
+	logger.setNewFileCallback([index]() { writeSites(index); });
+	Logger::setOutputFunction(
+		[&logger](const char* msg, const uint64_t len) {
+			logger.output(msg, len);
+		},
+		[&logger]() { logger.flush(); },
+		index);
+}
@@ -0,0 +1,343 @@
+/**
+ * @file   BinaryLog.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/Logger.h>
+#include <xiao/utils/LogFormat.h>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <stdint.h>
+#include <string.h>
+
+BEGIN_NAMESPACE(xiao)
+
+class AsyncFileLogger;
+
+/**
+ * @brief The layout of the binary logs. A binary log is a sequence of
+ * records in the byte order of the host, every record starts with a header:
+ *
+ *   uint16_t magic (xBinaryLogMagic), uint8_t type, uint8_t reserved,
+ *   uint32_t length (of the whole record)
+ *
+ * A site record describes a log statement, it is written before the first
+ * entry of the site:
+ *
+ *   uint32_t siteId, uint8_t level, int32_t line, uint8_t argCount,
+ *   char argTypes[argCount], uint16_t fileLength, char file[fileLength],
+ *   uint16_t formatLength, char format[formatLength]
+ *
+ * An entry record is one log:
+ *
+ *   uint32_t siteId, int64_t microSecondsSinceEpoch, uint64_t threadId,
+ *   the arguments
+ *
+ * The arguments are stored by type: 'i' int64_t, 'u' uint64_t, 'f' double,
+ * 'c' char, 'b' bool (one byte), 'p' uint64_t (a pointer), 's' uint32_t length followed by the
+ * characters. Anything which isn't a record (e.g. the messages of lost logs
+ * written by AsyncFileLogger) is a line of text.
+ */
+static constexpr uint16_t xBinaryLogMagic{ 0xB10C };
+static constexpr size_t xBinaryHeaderSize{ 8 };
+static constexpr size_t xBinaryEntryHeaderSize{ xBinaryHeaderSize + 20 };
+// Longer string arguments are truncated.
+static constexpr size_t xMaxBinaryRecordSize{ 4000 };
+
+enum BinaryRecordType : uint8_t
+{
+	xBinarySiteRecord = 1,
+	xBinaryEntryRecord = 2
+};
+
+/**
+ * @brief The static descriptor of a binary log statement. The id is assigned
+ * by the first log of the site, the site record is written to every index the
+ * site logs to.
+ */
+struct BinaryLogSite
+{
+	constexpr BinaryLogSite(const char* file, int line, Logger::LogLevel level)
+		: file_(file), line_(line), level_(level)
+	{
+	}
+
+	const char* file_;
+	int line_;
+	Logger::LogLevel level_;
+	std::atomic<uint32_t> id_{ 0 };
+	// the last index the site record was written to
+	std::atomic<int> index_{ 0 };
+};
+
+BEGIN_NAMESPACE(internal)
+
+// Encode one argument of a binary log, the arguments of unsupported types
+// don't compile.
+template <typename T, typename Enable = void>
+struct BinaryArg;
+
+template <typename T>
+struct BinaryArg<T,
+	typename std::enable_if<(std::is_integral<T>::value &&
+		std::is_signed<T>::value && !std::is_same<T, char>::value) ||
+		std::is_enum<T>::value>::type>
+{
+	static constexpr char xType = 'i';
+	static constexpr size_t xSize = sizeof(int64_t);
+	static char* encode(char* p, char*, T v)
+	{
+		auto value = static_cast<int64_t>(v);
+		memcpy(p, &value, sizeof(value));
+		return p + sizeof(value);
+	}
+};
+
+template <typename T>
+struct BinaryArg<T,
+	typename std::enable_if<std::is_integral<T>::value &&
+		!std::is_signed<T>::value && !std::is_same<T, char>::value &&
+		!std::is_same<T, bool>::value>::type>
+{
+	static constexpr char xType = 'u';
+	static constexpr size_t xSize = sizeof(uint64_t);
+	static char* encode(char* p, char*, T v)
+	{
+		auto value = static_cast<uint64_t>(v);
+		memcpy(p, &value, sizeof(value));
+		return p + sizeof(value);
+	}
+};
+
+template <>
+struct BinaryArg<bool>
+{
+	static constexpr char xType = 'b';
+	static constexpr size_t xSize = 1;
+	static char* encode(char* p, char*, bool v)
+	{
+		*p = v ? 1 : 0;
+		return p + 1;
+	}
+};
+
+template <>
+struct BinaryArg<char>
+{
+	static constexpr char xType = 'c';
+	static constexpr size_t xSize = 1;
+	static char* encode(char* p, char*, char v)
+	{
+		*p = v;
+		return p + 1;
+	}
+};
+
+template <typename T>
+struct BinaryArg<T,
+	typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+	static constexpr char xType = 'f';
+	static constexpr size_t xSize = sizeof(double);
+	static char* encode(char* p, char*, T v)
+	{
+		auto value = static_cast<double>(v);
+		memcpy(p, &value, sizeof(value));
+		return p + sizeof(value);
+	}
+};
+
+// The string is truncated to the room left in the record, end is reduced by
+// the room reserved for the following arguments.
+inline char* encodeBinaryString(char* p, char* end, const char* str, size_t len)
+{
+	size_t room = static_cast<size_t>(end - p) - sizeof(uint32_t);
+	if (len > room)
+		len = room;
+	auto length = static_cast<uint32_t>(len);
+	memcpy(p, &length, sizeof(length));
+	memcpy(p + sizeof(length), str, len);
+	return p + sizeof(length) + len;
+}
+
+template <typename T>
+struct BinaryArg<T,
+	typename std::enable_if<std::is_same<T, const char*>::value ||
+		std::is_same<T, char*>::value>::type>
+{
+	static constexpr char xType = 's';
+	static constexpr size_t xSize = sizeof(uint32_t);
+	static char* encode(char* p, char* end, const char* v)
+	{
+		if (!v)
+			return encodeBinaryString(p, end, "(null)", 6);
+		return encodeBinaryString(p, end, v, strlen(v));
+	}
+};
+
+template <>
+struct BinaryArg<std::string>
+{
+	static constexpr char xType = 's';
+	static constexpr size_t xSize = sizeof(uint32_t);
+	static char* encode(char* p, char* end, const std::string& v)
+	{
+		return encodeBinaryString(p, end, v.data(), v.size());
+	}
+};
+
+template <typename T>
+struct BinaryArg<T,
+	typename std::enable_if<std::is_pointer<T>::value &&
+		!std::is_same<T, const char*>::value &&
+		!std::is_same<T, char*>::value>::type>
+{
+	static constexpr char xType = 'p';
+	static constexpr size_t xSize = sizeof(uint64_t);
+	static char* encode(char* p, char*, T v)
+	{
+		auto value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v));
+		memcpy(p, &value, sizeof(value));
+		return p + sizeof(value);
+	}
+};
+
+template <typename T>
+using BinaryArgOf = BinaryArg<typename std::decay<T>::type>;
+
+// The size of the fixed parts of the arguments.
+template <typename... Args>
+struct BinaryArgsSize
+{
+	static constexpr size_t value = 0;
+};
+
+template <typename T, typename... Args>
+struct BinaryArgsSize<T, Args...>
+{
+	static constexpr size_t value =
+		BinaryArgOf<T>::xSize + BinaryArgsSize<Args...>::value;
+};
+
+inline char* encodeBinaryArgs(char* p, char*)
+{
+	return p;
+}
+
+template <typename T, typename... Args>
+char* encodeBinaryArgs(char* p, char* end, const T& arg, const Args&... args)
+{
+	// the room of the fixed parts of the following arguments is kept
+	p = BinaryArgOf<T>::encode(p, end - BinaryArgsSize<Args...>::value, arg);
+	return encodeBinaryArgs(p, end, args...);
+}
+
+END_NAMESPACE(internal)
+
+/**
+ * @brief This class writes binary logs (see the LOG_BIN_* macros). Instead of
+ * formatting the text, a log records the id of its site, the timestamp and
+ * the raw bytes of the arguments, the format string is written once per
+ * site and log file. The text is rendered offline by xiao_log_decoder. Binary
+ * logs should be sent to their own output (e.g. LOG_BIN_INFO_TO(1, ...) with
+ * a dedicated AsyncFileLogger, see attach()), the text logs would be rendered
+ * as is.
+ */
+class XIAO_EXPORT BinaryLogger : public NonCopyable
+{
+public:
+	template <typename... Args>
+	static void log(BinaryLogSite& site,
+		int index,
+		const char* format,
+		const Args&... args)
+	{
+		static_assert(internal::BinaryArgsSize<Args...>::value <=
+				xMaxBinaryRecordSize - xBinaryEntryHeaderSize,
+			"too many arguments for a binary log");
+		static const char argTypes[] = {
+			internal::BinaryArgOf<Args>::xType..., '\0'
+		};
+		uint32_t id = site.id_.load(std::memory_order_acquire);
+		if (id == 0 || site.index_.load(std::memory_order_acquire) != index)
+			id = registerSite(site, index, format, argTypes, sizeof...(Args));
+		char buf[xMaxBinaryRecordSize];
+		char* end = internal::encodeBinaryArgs(
+			buf + xBinaryEntryHeaderSize, buf + sizeof(buf), args...);
+		writeEntry(site, index, id, buf, static_cast<size_t>(end - buf));
+	}
+
+	/**
+	 * @brief Write the site records of all the sites logged so far to the
+	 * output of the index, e.g. at the beginning of a new log file, so the
+	 * file can be decoded alone.
+	 */
+	static void writeSites(int index = -1);
+
+	/**
+	 * @brief Make the logger the output of the index and write the site
+	 * records at the beginning of every new log file of the logger, so the
+	 * files can be decoded alone even after the older ones are deleted or
+	 * compressed. Must be called before logger.startLogging().
+	 */
+	static void attach(AsyncFileLogger& logger, int index = -1);
+
+private:
+	static uint32_t registerSite(BinaryLogSite& site,
+		int index,
+		const char* format,
+		const char* argTypes,
+		size_t argCount);
+	static void writeEntry(const BinaryLogSite& site,
+		int index,
+		uint32_t id,
+		char* buf,
+		size_t len);
+};
+
+// LOG_BIN_INFO("x={} y={:.3f}", x, y) takes the format of LOG_INFO_FMT, it's
+// checked against the arguments at compile time and rendered by
+// xiao_log_decoder. The site filters of the text logs apply, e.g. the module
+// levels.
+#define XIAO_BINARY_LOG_(index, level, ...)                                 \
+  XIAO_SITE_IF_((level), (level) >= xiao::Logger::xWarn ||                  \
+                             _site->levelEnabled(level))                    \
+  do {                                                                      \
+    static constexpr auto xiaoFormat_ = xiao::internal::parseFormat(       \
+        XIAO_FMT_STRING_(__VA_ARGS__),                                      \
+        decltype(xiao::internal::formatArgs(__VA_ARGS__)){});               \
+    (void)xiaoFormat_;                                                      \
+    static xiao::BinaryLogSite xiaoBinaryLogSite_(__FILE__, __LINE__,       \
+                                                  (level));                 \
+    xiao::BinaryLogger::log(xiaoBinaryLogSite_, (index), __VA_ARGS__);      \
+  } while (0)
+
+#define LOG_BIN_TRACE(...) \
+  XIAO_BINARY_LOG_(-1, xiao::Logger::xTrace, __VA_ARGS__)
+#define LOG_BIN_TRACE_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xTrace, __VA_ARGS__)
+#define LOG_BIN_DEBUG(...) \
+  XIAO_BINARY_LOG_(-1, xiao::Logger::xDebug, __VA_ARGS__)
+#define LOG_BIN_DEBUG_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xDebug, __VA_ARGS__)
+#define LOG_BIN_INFO(...) XIAO_BINARY_LOG_(-1, xiao::Logger::xInfo, __VA_ARGS__)
+#define LOG_BIN_INFO_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xInfo, __VA_ARGS__)
+#define LOG_BIN_WARN(...) XIAO_BINARY_LOG_(-1, xiao::Logger::xWarn, __VA_ARGS__)
+#define LOG_BIN_WARN_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xWarn, __VA_ARGS__)
+#define LOG_BIN_ERROR(...) \
+  XIAO_BINARY_LOG_(-1, xiao::Logger::xError, __VA_ARGS__)
+#define LOG_BIN_ERROR_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xError, __VA_ARGS__)
+#define LOG_BIN_FATAL(...) \
+  XIAO_BINARY_LOG_(-1, xiao::Logger::xFatal, __VA_ARGS__)
+#define LOG_BIN_FATAL_TO(index, ...) \
+  XIAO_BINARY_LOG_(index, xiao::Logger::xFatal, __VA_ARGS__)
+
+END_NAMESPACE(xiao)
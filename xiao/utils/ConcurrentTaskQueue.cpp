@@ -9,76 +9,332 @@
 #include <xiao/utils/ConcurrentTaskQueue.h>
 #include <xiao/utils/Logger.h>
 #include <assert.h>
+#include <random>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 
 using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+// The max number of tasks a worker moves from the injection queue to its own
+// deque at once in work-stealing mode.
+static constexpr size_t xMaxInjectionBatch{ 32 };
+// The max number of tasks a worker takes from the shared queue per lock
+// acquisition.
+static constexpr size_t xMaxDrainBatch{ 16 };
+
+struct WorkerContext
+{
+	const ConcurrentTaskQueue* queue_{ nullptr };
+	size_t index_{ 0 };
+};
+static thread_local WorkerContext t_worker;
+
+// The boxes of the tasks in the deques are recycled per thread, so running a
+// task in work-stealing mode doesn't allocate either in the steady state.
+static constexpr size_t xMaxCachedTaskBoxes{ 256 };
+
+struct TaskBoxCache
+{
+	std::vector<SmallTask*> boxes_;
+	~TaskBoxCache()
+	{
+		for (auto box : boxes_)
+			delete box;
+	}
+};
+static thread_local TaskBoxCache t_taskBoxes;
+
+static SmallTask* newTaskBox(SmallTask&& task)
+{
+	auto& boxes = t_taskBoxes.boxes_;
+	if (boxes.empty())
+		return new SmallTask(std::move(task));
+	SmallTask* box = boxes.back();
+	boxes.pop_back();
+	*box = std::move(task);
+	return box;
+}
+
+static void releaseTaskBox(SmallTask* box)
+{
+	box->reset();
+	auto& boxes = t_taskBoxes.boxes_;
+	if (boxes.size() < xMaxCachedTaskBoxes)
+		boxes.push_back(box);
+	else
+		delete box;
+}
+END_NAMESPACE(xiao)
+
 ConcurrentTaskQueue::ConcurrentTaskQueue(size_t threadNum,
-										 const std::string& name) 
-	: queueCount_(threadNum), queueName_(name), stop_(false)
+										 const std::string& name,
+										 ScheduleMode mode)
+	: queueName_(name), queueCount_(threadNum), mode_(mode), stop_(false)
 {
 	assert(threadNum > 0);
+	if (mode_ == xWorkStealing)
+	{
+		for (unsigned int i = 0; i < queueCount_; ++i)
+		{
+			localQueues_.emplace_back(new WorkStealingDeque<TaskPtr>);
+		}
+	}
 	for (unsigned int i = 0; i < queueCount_; ++i)
 	{
-		threads_.push_back(
-			std::thread(std::bind(&ConcurrentTaskQueue::queueFunc, this, i)));
+		if (mode_ == xWorkStealing)
+			threads_.push_back(std::thread(
+				std::bind(&ConcurrentTaskQueue::stealingQueueFunc, this, i)));
+		else
+			threads_.push_back(
+				std::thread(std::bind(&ConcurrentTaskQueue::queueFunc, this, i)));
 	}
 }
 void ConcurrentTaskQueue::runTaskInQueue(const std::function<void()>& task)
 {
 	LOG_TRACE << "copy task into queue";
-	std::lock_guard<std::mutex> lock(taskMutex_);
-	taskQueue_.push(std::move(task));
-	taskCond_.notify_one();
+	runTaskInQueue(SmallTask(task));
 }
 void ConcurrentTaskQueue::runTaskInQueue(std::function<void()>&& task)
 {
 	LOG_TRACE << "move task into queue";
-	std::lock_guard<std::mutex> lock(taskMutex_);
-	taskQueue_.push(std::move(task));
+	runTaskInQueue(SmallTask(std::move(task)));
+}
+void ConcurrentTaskQueue::runTaskInQueue(SmallTask&& task)
+{
+	if (mode_ == xWorkStealing)
+	{
+		pushTask(std::move(task));
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(taskMutex_);
+		pushToQueue(std::move(task));
+	}
 	taskCond_.notify_one();
 }
+void ConcurrentTaskQueue::pushToQueue(SmallTask&& task)
+{
+	if (taskHead_ > 0 && taskQueue_.size() == taskQueue_.capacity())
+	{
+		// move the pending tasks to the front instead of growing the storage
+		taskQueue_.erase(taskQueue_.begin(), taskQueue_.begin() + taskHead_);
+		taskHead_ = 0;
+	}
+	taskQueue_.push_back(std::move(task));
+}
+SmallTask ConcurrentTaskQueue::popFromQueue()
+{
+	assert(queueSize() > 0);
+	SmallTask task(std::move(taskQueue_[taskHead_]));
+	if (++taskHead_ == taskQueue_.size())
+	{
+		taskQueue_.clear();
+		taskHead_ = 0;
+	}
+	return task;
+}
 void ConcurrentTaskQueue::queueFunc(int queueNum)
 {
 	char tmpName[32];
 	snprintf(tmpName, sizeof(tmpName), "%s%d", queueName_.c_str(), queueNum);
 #ifdef __linux__
-	::PRECTL(PR_SET_NAME, tmpName);
+	::prctl(PR_SET_NAME, tmpName);
 #endif // __linux__
+	std::vector<SmallTask> tasks;
+	tasks.reserve(xMaxDrainBatch);
 	while (!stop_)
 	{
-		std::function<void()> r;
 		{
 			std::unique_lock<std::mutex> lock(taskMutex_);
-			while (taskQueue_.size() == 0 && !stop_)
+			while (queueSize() == 0 && !stop_)
 			{
 				taskCond_.wait(lock);
 			}
-			if (taskQueue_.size() > 0)
+			if (queueSize() == 0)
+				continue;
+			// take a fair share of the queue so the other workers woken up
+			// for the same batch aren't left idle.
+			size_t batch = (queueSize() + queueCount_ - 1) / queueCount_;
+			if (batch > xMaxDrainBatch)
+				batch = xMaxDrainBatch;
+			LOG_TRACE << "got " << batch << " new tasks!";
+			for (size_t i = 0; i < batch; ++i)
+			{
+				tasks.push_back(popFromQueue());
+			}
+		}
+		for (auto& task : tasks)
+		{
+			task();
+		}
+		tasks.clear();
+	}
+}
+
+void ConcurrentTaskQueue::pushTask(SmallTask&& task)
+{
+	// pendingTasks_ is increased before the task is visible, so a worker
+	// taking it can't decrease the count below zero.
+	if (isCurrentWorker())
+	{
+		// submitted from a worker of this queue, no lock is needed.
+		pendingTasks_.fetch_add(1);
+		pushToLocalQueue(std::move(task));
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(taskMutex_);
+		if (mode_ == xWorkStealing)
+			pendingTasks_.fetch_add(1);
+		pushToQueue(std::move(task));
+	}
+	notifyWorkers(1);
+}
+
+bool ConcurrentTaskQueue::isCurrentWorker() const
+{
+	return t_worker.queue_ == this;
+}
+
+void ConcurrentTaskQueue::pushToLocalQueue(SmallTask&& task)
+{
+	assert(isCurrentWorker());
+	localQueues_[t_worker.index_]->push(newTaskBox(std::move(task)));
+}
+
+void ConcurrentTaskQueue::notifyWorkers(size_t count)
+{
+	std::unique_lock<std::mutex> lock(taskMutex_, std::defer_lock);
+	if (mode_ == xWorkStealing)
+	{
+		// pendingTasks_ is increased before sleepingWorkers_ is read, and a
+		// worker increases sleepingWorkers_ before it reads pendingTasks_, so
+		// either the worker sees the task or we see the sleeping worker.
+		size_t sleeping = sleepingWorkers_.load();
+		if (sleeping == 0)
+			return;
+		if (count > sleeping)
+			count = sleeping;
+		lock.lock();
+	}
+	if (count >= queueCount_)
+	{
+		taskCond_.notify_all();
+		return;
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		taskCond_.notify_one();
+	}
+}
+
+bool ConcurrentTaskQueue::getTask(size_t queueNum, TaskPtr& task)
+{
+	auto& localQueue = localQueues_[queueNum];
+	if (localQueue->pop(task))
+	{
+		pendingTasks_.fetch_sub(1);
+		return true;
+	}
+	{
+		std::lock_guard<std::mutex> lock(taskMutex_);
+		if (queueSize() > 0)
+		{
+			task = newTaskBox(popFromQueue());
+			pendingTasks_.fetch_sub(1);
+			// take a share of the injection queue into the local deque, so
+			// the following tasks don't need the lock.
+			size_t batch = queueSize() / queueCount_;
+			if (batch > xMaxInjectionBatch)
+				batch = xMaxInjectionBatch;
+			for (size_t i = 0; i < batch; ++i)
 			{
-				LOG_TRACE << "got a new task!";
-				r = std::move(taskQueue_.front());
-				taskQueue_.pop();
+				localQueue->push(newTaskBox(popFromQueue()));
 			}
-			else
+			return true;
+		}
+	}
+	if (queueCount_ > 1)
+	{
+		static thread_local std::minstd_rand rng(
+			static_cast<unsigned int>(std::hash<std::thread::id>()(
+				std::this_thread::get_id())));
+		size_t start = rng() % queueCount_;
+		for (size_t i = 0; i < queueCount_; ++i)
+		{
+			size_t victim = (start + i) % queueCount_;
+			if (victim == queueNum)
 				continue;
+			if (localQueues_[victim]->steal(task))
+			{
+				pendingTasks_.fetch_sub(1);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ConcurrentTaskQueue::stealingQueueFunc(int queueNum)
+{
+	char tmpName[32];
+	snprintf(tmpName, sizeof(tmpName), "%s%d", queueName_.c_str(), queueNum);
+#ifdef __linux__
+	::prctl(PR_SET_NAME, tmpName);
+#endif // __linux__
+	t_worker.queue_ = this;
+	t_worker.index_ = static_cast<size_t>(queueNum);
+	while (!stop_)
+	{
+		TaskPtr task;
+		if (getTask(queueNum, task))
+		{
+			LOG_TRACE << "got a new task!";
+			(*task)();
+			releaseTaskBox(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(taskMutex_);
+		sleepingWorkers_.fetch_add(1);
+		while (pendingTasks_.load() == 0 && !stop_)
+		{
+			taskCond_.wait(lock);
 		}
-		r();
+		sleepingWorkers_.fetch_sub(1);
 	}
+	t_worker.queue_ = nullptr;
 }
 
 size_t ConcurrentTaskQueue::getTaskCount()
 {
+	if (mode_ == xWorkStealing)
+		return pendingTasks_.load();
 	std::lock_guard<std::mutex> guard(taskMutex_);
-	return taskQueue_.size();
+	return queueSize();
 }
 
 void ConcurrentTaskQueue::stop()
 {
 	if (!stop_)
 	{
-		stop_ = true;
+		{
+			std::lock_guard<std::mutex> lock(taskMutex_);
+			stop_ = true;
+		}
 		taskCond_.notify_all();
 		for (auto& t : threads_)
 			t.join();
+		// release the tasks left in the deques
+		for (auto& localQueue : localQueues_)
+		{
+			TaskPtr task;
+			while (localQueue->steal(task))
+			{
+				delete task;
+			}
+		}
 	}
 }
 ConcurrentTaskQueue::~ConcurrentTaskQueue()
@@ -7,7 +7,14 @@
  */
 #pragma once
 #include <xiao/utils/TaskQueue.h>
-#include <queue>
+#include <xiao/utils/LockFreeQueue.h>
+#include <iterator>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
 
 BEGIN_NAMESPACE(xiao)
 
@@ -19,10 +26,66 @@ BEGIN_NAMESPACE(xiao)
 class XIAO_EXPORT ConcurrentTaskQueue : public TaskQueue
 {
 public:
-	ConcurrentTaskQueue(size_t threadNum, const std::string& name);
+	enum ScheduleMode
+	{
+		// All workers take tasks from one shared queue.
+		xSharedQueue = 0,
+		// Every worker has its own deque, tasks submitted from a worker go to
+		// its deque, and idle workers steal from random victims. Tasks
+		// submitted from other threads go to a shared injection queue.
+		xWorkStealing
+	};
+
+	ConcurrentTaskQueue(size_t threadNum,
+						const std::string& name,
+						ScheduleMode mode = xSharedQueue);
 
 	virtual void runTaskInQueue(const std::function<void()>& task);
 	virtual void runTaskInQueue(std::function<void()>&& task);
+	virtual void runTaskInQueue(SmallTask&& task);
+
+	/**
+	 * @brief Run a batch of tasks in the queue. The tasks are moved out of the
+	 * range and queued under one lock, and at most as many workers as tasks
+	 * are woken up.
+	 *
+	 * \param first, last The range of the tasks, the elements can be
+	 * SmallTask, std::function<void()> or any callable type.
+	 */
+	template <typename Iter>
+	void runTasksInQueue(Iter first, Iter last)
+	{
+		if (first == last)
+			return;
+		if (mode_ == xWorkStealing && isCurrentWorker())
+		{
+			size_t count = 0;
+			for (; first != last; ++first, ++count)
+			{
+				pendingTasks_.fetch_add(1);
+				pushToLocalQueue(SmallTask(std::move(*first)));
+			}
+			notifyWorkers(count);
+			return;
+		}
+		size_t count = 0;
+		{
+			std::lock_guard<std::mutex> lock(taskMutex_);
+			for (; first != last; ++first, ++count)
+			{
+				pushToQueue(SmallTask(std::move(*first)));
+			}
+			if (mode_ == xWorkStealing)
+				pendingTasks_.fetch_add(count);
+		}
+		notifyWorkers(count);
+	}
+
+	template <typename Container>
+	void runTasksInQueue(Container& tasks)
+	{
+		runTasksInQueue(std::begin(tasks), std::end(tasks));
+	}
 
 	virtual std::string getName() const
 	{
@@ -31,22 +94,52 @@ public:
 
 	size_t getTaskCount();
 
+	ScheduleMode scheduleMode() const
+	{
+		return mode_;
+	}
+
 	void stop();
 
 	~ConcurrentTaskQueue();
 
 private:
+	using TaskPtr = SmallTask*;
+
 	std::string queueName_;
 	size_t queueCount_;
+	ScheduleMode mode_;
 
 	std::atomic_bool stop_;
 
-	std::queue<std::function<void()>> taskQueue_;
+	// The shared queue (the injection queue in work-stealing mode). Popped
+	// tasks are skipped by taskHead_, the storage is reused when the queue
+	// gets empty or full, so the tasks are queued without allocation.
+	std::vector<SmallTask> taskQueue_;
+	size_t taskHead_{ 0 };
+	void pushToQueue(SmallTask&& task);
+	SmallTask popFromQueue();
+	size_t queueSize() const
+	{
+		return taskQueue_.size() - taskHead_;
+	}
+
 	std::vector<std::thread> threads_;
 	void queueFunc(int queueNum);
 
 	std::mutex taskMutex_;
 	std::condition_variable taskCond_;
+
+	// work-stealing mode
+	std::vector<std::unique_ptr<WorkStealingDeque<TaskPtr>>> localQueues_;
+	std::atomic<size_t> pendingTasks_{ 0 };
+	std::atomic<size_t> sleepingWorkers_{ 0 };
+	void stealingQueueFunc(int queueNum);
+	void pushTask(SmallTask&& task);
+	bool getTask(size_t queueNum, TaskPtr& task);
+	bool isCurrentWorker() const;
+	void pushToLocalQueue(SmallTask&& task);
+	void notifyWorkers(size_t count);
 };
 
 
@@ -0,0 +1,354 @@
+/**
+ * @file   Coroutine.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/TaskQueue.h>
+#include <xiao/utils/Future.h>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define XIAO_HAS_COROUTINE 1
+#endif
+#endif
+
+#ifdef XIAO_HAS_COROUTINE
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+BEGIN_NAMESPACE(xiao)
+
+template <typename T = void>
+class Task;
+
+BEGIN_NAMESPACE(internal)
+
+/**
+ * @brief The part of the promise of Task<T> that doesn't depend on T. A task
+ * starts suspended and, when it finishes, transfers control to the coroutine
+ * awaiting it (symmetric transfer), so chains of tasks don't grow the stack.
+ */
+class TaskPromiseBase
+{
+public:
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(
+			std::coroutine_handle<Promise> handle) noexcept
+		{
+			auto continuation = handle.promise().continuation_;
+			if (continuation)
+				return continuation;
+			return std::noop_coroutine();
+		}
+
+		void await_resume() noexcept
+		{
+		}
+	};
+
+	std::suspend_always initial_suspend() noexcept
+	{
+		return {};
+	}
+
+	FinalAwaiter final_suspend() noexcept
+	{
+		return {};
+	}
+
+	void unhandled_exception() noexcept
+	{
+		exception_ = std::current_exception();
+	}
+
+	void setContinuation(std::coroutine_handle<> continuation) noexcept
+	{
+		continuation_ = continuation;
+	}
+
+protected:
+	void rethrowIfFailed()
+	{
+		if (exception_)
+			std::rethrow_exception(exception_);
+	}
+
+private:
+	std::coroutine_handle<> continuation_;
+	std::exception_ptr exception_;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+	Task<T> get_return_object() noexcept;
+
+	template <typename U>
+	void return_value(U&& value)
+	{
+		value_.emplace(std::forward<U>(value));
+	}
+
+	T result()
+	{
+		rethrowIfFailed();
+		return std::move(*value_);
+	}
+
+private:
+	std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+	Task<void> get_return_object() noexcept;
+
+	void return_void() noexcept
+	{
+	}
+
+	void result()
+	{
+		rethrowIfFailed();
+	}
+};
+
+END_NAMESPACE(internal)
+
+/**
+ * @brief This class template is the coroutine type of xiao. A task is lazy,
+ * it starts running when it is awaited, and the awaiting coroutine is resumed
+ * as soon as the task finishes. Use switchTo() to move a task onto a task
+ * queue and toFuture() to start a task from non-coroutine code.
+ */
+template <typename T>
+class [[nodiscard]] Task
+{
+public:
+	using promise_type = internal::TaskPromise<T>;
+	using Handle = std::coroutine_handle<promise_type>;
+
+	Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr))
+	{
+	}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle_)
+				handle_.destroy();
+			handle_ = std::exchange(other.handle_, nullptr);
+		}
+		return *this;
+	}
+
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task()
+	{
+		if (handle_)
+			handle_.destroy();
+	}
+
+	auto operator co_await() && noexcept
+	{
+		struct Awaiter
+		{
+			Handle handle_;
+
+			bool await_ready() const noexcept
+			{
+				return !handle_ || handle_.done();
+			}
+
+			std::coroutine_handle<> await_suspend(
+				std::coroutine_handle<> awaiting) noexcept
+			{
+				handle_.promise().setContinuation(awaiting);
+				return handle_;
+			}
+
+			T await_resume()
+			{
+				return handle_.promise().result();
+			}
+		};
+		return Awaiter{ handle_ };
+	}
+
+private:
+	friend class internal::TaskPromise<T>;
+
+	explicit Task(Handle handle) noexcept : handle_(handle)
+	{
+	}
+
+	Handle handle_;
+};
+
+BEGIN_NAMESPACE(internal)
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+	return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+	return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+// A coroutine which starts eagerly and destroys itself when it finishes,
+// used to bridge tasks to futures.
+struct DetachedCoroutine
+{
+	struct promise_type
+	{
+		DetachedCoroutine get_return_object() noexcept
+		{
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+		void return_void() noexcept
+		{
+		}
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+	};
+};
+
+template <typename T>
+DetachedCoroutine fulfillFromTask(Task<T> task, Promise<T> promise)
+{
+	std::exception_ptr exception;
+	try
+	{
+		if constexpr (std::is_void<T>::value)
+		{
+			co_await std::move(task);
+			promise.setValue();
+		}
+		else
+		{
+			promise.setValue(co_await std::move(task));
+		}
+	}
+	catch (...)
+	{
+		// thrown by the continuations of the promise, not by the task
+		if (promise.satisfied())
+			throw;
+		exception = std::current_exception();
+	}
+	if (exception)
+		promise.setException(exception);
+}
+
+END_NAMESPACE(internal)
+
+/**
+ * @brief Start the task in the current thread and return a future of its
+ * result.
+ */
+template <typename T>
+Future<T> toFuture(Task<T> task)
+{
+	Promise<T> promise;
+	auto future = promise.getFuture();
+	internal::fulfillFromTask(std::move(task), std::move(promise));
+	return future;
+}
+
+/**
+ * @brief Return an awaitable which resumes the current coroutine in the given
+ * queue, e.g. co_await switchTo(cpuPool). The resumption is queued as a
+ * SmallTask, so a hop doesn't allocate on queues storing SmallTask natively.
+ */
+inline auto switchTo(TaskQueue& queue) noexcept
+{
+	struct Awaiter
+	{
+		TaskQueue& queue_;
+
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			queue_.runTaskInQueue(SmallTask([handle]() { handle.resume(); }));
+		}
+
+		void await_resume() noexcept
+		{
+		}
+	};
+	return Awaiter{ queue };
+}
+
+/**
+ * @brief Make futures awaitable, e.g. co_await queue.submit(f). The coroutine
+ * is resumed in the thread that sets the result of the future.
+ */
+template <typename T>
+auto operator co_await(Future<T>&& future) noexcept
+{
+	struct Awaiter
+	{
+		Future<T> future_;
+
+		bool await_ready() const noexcept
+		{
+			return future_.isReady();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			// The coroutine may be resumed before onReady() returns, nothing
+			// in this frame is touched after that.
+			future_.onReady([this, handle](Future<T>&& ready) {
+				future_ = std::move(ready);
+				handle.resume();
+			});
+		}
+
+		T await_resume()
+		{
+			return future_.get();
+		}
+	};
+	return Awaiter{ std::move(future) };
+}
+
+END_NAMESPACE(xiao)
+
+#endif // XIAO_HAS_COROUTINE
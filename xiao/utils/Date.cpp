@@ -8,6 +8,7 @@
 #include "Date.h"
 #include <chrono>
 #include <vector>
+#include <string.h>
 #include "Funcs.h"
 
 BEGIN_NAMESPACE(xiao)
@@ -92,7 +93,7 @@ std::string Date::toCustomedFormattedString(const std::string& fmtStr,
 	time_t seconds = static_cast<time_t>(microSecondSinceEpoch_ / MICRO_SECONDS_PER_SEC);
 	std::tm tm_time;
 #ifndef _WIN32
-	gmtime_t(&seconds, &tm_time);
+	gmtime_r(&seconds, &tm_time);
 #else
 	gmtime_s(&tm_time, &seconds);
 #endif // !_WIN32
@@ -0,0 +1,540 @@
+/**
+ * @file   Future.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/utils/InlineTask.h>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+BEGIN_NAMESPACE(xiao)
+
+template <typename T>
+class Future;
+template <typename T>
+class Promise;
+
+BEGIN_NAMESPACE(internal)
+
+struct Unit
+{
+};
+
+template <typename T>
+struct StoredType
+{
+	using type = T;
+};
+
+template <>
+struct StoredType<void>
+{
+	using type = Unit;
+};
+
+// Call a continuation with the value of a Future<T>.
+template <typename T>
+struct Apply
+{
+	template <typename F>
+	static auto call(F& f, T&& value) -> decltype(f(std::move(value)))
+	{
+		return f(std::move(value));
+	}
+};
+
+template <>
+struct Apply<void>
+{
+	template <typename F>
+	static auto call(F& f, Unit&&) -> decltype(f())
+	{
+		return f();
+	}
+};
+
+template <typename F, typename T>
+struct ContinuationResult
+{
+	using type = decltype(Apply<T>::call(std::declval<F&>(),
+		std::declval<typename StoredType<T>::type>()));
+};
+
+/**
+ * @brief The state shared by a promise and its future. The producer and the
+ * consumer each set one bit of state_ after storing the result or the
+ * continuation, whoever comes second runs the continuation, so no lock is
+ * taken.
+ */
+template <typename T>
+class FutureState : public std::enable_shared_from_this<FutureState<T>>,
+					public NonCopyable
+{
+public:
+	using Stored = typename StoredType<T>::type;
+
+	~FutureState()
+	{
+		if (hasValue_)
+			value().~Stored();
+	}
+
+	template <typename... Args>
+	void setValue(Args&&... args)
+	{
+		new (&storage_) Stored(std::forward<Args>(args)...);
+		hasValue_ = true;
+		complete();
+	}
+
+	void setException(std::exception_ptr exception)
+	{
+		exception_ = std::move(exception);
+		complete();
+	}
+
+	void setContinuation(SmallTask&& continuation)
+	{
+		continuation_ = std::move(continuation);
+		if (state_.fetch_or(xContinuationSet, std::memory_order_acq_rel) &
+			xResultSet)
+		{
+			runContinuation();
+		}
+	}
+
+	bool ready() const
+	{
+		return (state_.load(std::memory_order_acquire) & xResultSet) != 0;
+	}
+
+	// The following methods can only be called when the state is ready.
+	Stored& value()
+	{
+		return *reinterpret_cast<Stored*>(&storage_);
+	}
+
+	const std::exception_ptr& exception() const
+	{
+		return exception_;
+	}
+
+private:
+	enum
+	{
+		xResultSet = 1,
+		xContinuationSet = 2
+	};
+
+	void complete()
+	{
+		if (state_.fetch_or(xResultSet, std::memory_order_acq_rel) &
+			xContinuationSet)
+		{
+			runContinuation();
+		}
+	}
+
+	void runContinuation()
+	{
+		// the continuation may attach another one (see Future::wait())
+		SmallTask continuation(std::move(continuation_));
+		continuation();
+	}
+
+	std::atomic<int> state_{ 0 };
+	bool hasValue_{ false };
+	typename std::aligned_storage<sizeof(Stored), alignof(Stored)>::type
+		storage_;
+	std::exception_ptr exception_;
+	SmallTask continuation_;
+};
+
+END_NAMESPACE(internal)
+
+/**
+ * @brief This class template is the producer side of a Future. Destroying a
+ * promise without setting it breaks the future with
+ * std::future_errc::broken_promise.
+ */
+template <typename T>
+class Promise
+{
+public:
+	Promise() : state_(std::make_shared<internal::FutureState<T>>())
+	{
+	}
+	Promise(Promise&&) noexcept = default;
+	// An unsatisfied state is broken like in the destructor.
+	Promise& operator=(Promise&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		if (state_ && !satisfied_)
+		{
+			state_->setException(std::make_exception_ptr(
+				std::future_error(std::future_errc::broken_promise)));
+		}
+		state_ = std::move(other.state_);
+		satisfied_ = other.satisfied_;
+		return *this;
+	}
+	Promise(const Promise&) = delete;
+	Promise& operator=(const Promise&) = delete;
+
+	~Promise()
+	{
+		if (state_ && !satisfied_)
+		{
+			state_->setException(std::make_exception_ptr(
+				std::future_error(std::future_errc::broken_promise)));
+		}
+	}
+
+	Future<T> getFuture()
+	{
+		return Future<T>(state_);
+	}
+
+	/**
+	 * @brief Set the value (no argument for Promise<void>). The continuation
+	 * of the future, if any, is called in this thread.
+	 */
+	template <typename... Args>
+	void setValue(Args&&... args)
+	{
+		assert(state_ && !satisfied_);
+		satisfied_ = true;
+		state_->setValue(std::forward<Args>(args)...);
+	}
+
+	void setException(std::exception_ptr exception)
+	{
+		assert(state_ && !satisfied_);
+		satisfied_ = true;
+		state_->setException(std::move(exception));
+	}
+
+	bool satisfied() const
+	{
+		return satisfied_;
+	}
+
+private:
+	std::shared_ptr<internal::FutureState<T>> state_;
+	bool satisfied_{ false };
+};
+
+BEGIN_NAMESPACE(internal)
+
+// Run fn and store its result or exception into the promise.
+template <typename R>
+struct Fulfill
+{
+	template <typename Fn>
+	static void run(Promise<R>& promise, Fn& fn)
+	{
+		try
+		{
+			promise.setValue(fn());
+		}
+		catch (...)
+		{
+			// thrown by the continuations of the promise, not by fn
+			if (promise.satisfied())
+				throw;
+			promise.setException(std::current_exception());
+		}
+	}
+};
+
+template <>
+struct Fulfill<void>
+{
+	template <typename Fn>
+	static void run(Promise<void>& promise, Fn& fn)
+	{
+		try
+		{
+			fn();
+		}
+		catch (...)
+		{
+			promise.setException(std::current_exception());
+			return;
+		}
+		promise.setValue();
+	}
+};
+
+END_NAMESPACE(internal)
+
+/**
+ * @brief This class template represents the result of an asynchronous task.
+ * Unlike std::future, a continuation can be attached to it, the continuation
+ * is called by the thread that sets the result, so no thread is blocked while
+ * waiting. A future is move-only and can be consumed only once, by get(),
+ * then() or onReady().
+ */
+template <typename T>
+class Future
+{
+public:
+	Future() = default;
+	Future(Future&&) noexcept = default;
+	Future& operator=(Future&&) noexcept = default;
+	Future(const Future&) = delete;
+	Future& operator=(const Future&) = delete;
+
+	bool valid() const
+	{
+		return state_ != nullptr;
+	}
+
+	bool isReady() const
+	{
+		assert(state_);
+		return state_->ready();
+	}
+
+	/**
+	 * @brief Block the current thread until the future is ready.
+	 */
+	void wait()
+	{
+		assert(state_);
+		if (state_->ready())
+			return;
+		// the promise is shared since the producer may still be inside
+		// set_value() when this thread wakes up.
+		auto done = std::make_shared<std::promise<void>>();
+		std::future<void> doneFuture = done->get_future();
+		state_->setContinuation(SmallTask([done]() { done->set_value(); }));
+		doneFuture.wait();
+	}
+
+	/**
+	 * @brief Wait for the result and return it, the exception of the task is
+	 * rethrown.
+	 */
+	T get()
+	{
+		wait();
+		auto state = std::move(state_);
+		if (state->exception())
+			std::rethrow_exception(state->exception());
+		return static_cast<T>(std::move(state->value()));
+	}
+
+	/**
+	 * @brief Call f with the ready future when the result is set. f is called
+	 * in the thread that sets the result, or in this thread if the future is
+	 * already ready.
+	 */
+	template <typename F>
+	void onReady(F&& f)
+	{
+		assert(state_);
+		auto state = std::move(state_);
+		internal::FutureState<T>* rawState = state.get();
+		state->setContinuation(
+			SmallTask([rawState, f = std::forward<F>(f)]() mutable {
+				f(Future<T>(rawState->shared_from_this()));
+			}));
+	}
+
+	/**
+	 * @brief Attach a continuation which is called with the value (nothing for
+	 * Future<void>), the returned future holds the result of the continuation.
+	 * If this future holds an exception, the continuation is skipped and the
+	 * exception is passed on.
+	 */
+	template <typename F>
+	auto then(F&& f) -> Future<typename internal::ContinuationResult<
+		typename std::decay<F>::type, T>::type>
+	{
+		using R = typename internal::ContinuationResult<
+			typename std::decay<F>::type, T>::type;
+		Promise<R> promise;
+		auto future = promise.getFuture();
+		onReady([promise = std::move(promise),
+				 f = std::forward<F>(f)](Future<T>&& ready) mutable {
+			runContinuation(ready.state_, promise, f);
+		});
+		return future;
+	}
+
+	/**
+	 * @brief Same as above, except that the continuation is run in the given
+	 * task queue (any type with runTaskInQueue(SmallTask&&)).
+	 */
+	template <typename Queue, typename F>
+	auto then(Queue& queue, F&& f) -> Future<typename internal::ContinuationResult<
+		typename std::decay<F>::type, T>::type>
+	{
+		using R = typename internal::ContinuationResult<
+			typename std::decay<F>::type, T>::type;
+		Promise<R> promise;
+		auto future = promise.getFuture();
+		onReady([&queue, promise = std::move(promise), f = std::forward<F>(f)](
+					Future<T>&& ready) mutable {
+			queue.runTaskInQueue(
+				SmallTask([state = std::move(ready.state_),
+						   promise = std::move(promise),
+						   f = std::move(f)]() mutable {
+					runContinuation(state, promise, f);
+				}));
+		});
+		return future;
+	}
+
+private:
+	template <typename U>
+	friend class Future;
+	friend class Promise<T>;
+
+	explicit Future(std::shared_ptr<internal::FutureState<T>> state)
+		: state_(std::move(state))
+	{
+	}
+
+	template <typename R, typename F>
+	static void runContinuation(
+		const std::shared_ptr<internal::FutureState<T>>& state,
+		Promise<R>& promise,
+		F& f)
+	{
+		if (state->exception())
+		{
+			promise.setException(state->exception());
+			return;
+		}
+		auto call = [&state, &f]() {
+			return internal::Apply<T>::call(f, std::move(state->value()));
+		};
+		internal::Fulfill<R>::run(promise, call);
+	}
+
+	std::shared_ptr<internal::FutureState<T>> state_;
+};
+
+/**
+ * @brief Return a future which is ready when all the given futures are ready.
+ * The values are in the order of the futures (T must be default
+ * constructible), the first exception, if any, is passed on.
+ */
+template <typename T>
+Future<std::vector<T>> whenAll(std::vector<Future<T>> futures)
+{
+	// Every value has its own memory location, unlike the elements of
+	// std::vector<bool>, as the continuations may run in different threads.
+	struct Slot
+	{
+		T value_;
+	};
+	struct Context
+	{
+		std::unique_ptr<Slot[]> values_;
+		size_t count_{ 0 };
+		std::atomic<size_t> remaining_;
+		std::mutex mutex_;
+		std::exception_ptr exception_;
+		Promise<std::vector<T>> promise_;
+	};
+	auto context = std::make_shared<Context>();
+	auto future = context->promise_.getFuture();
+	if (futures.empty())
+	{
+		context->promise_.setValue();
+		return future;
+	}
+	context->values_.reset(new Slot[futures.size()]());
+	context->count_ = futures.size();
+	context->remaining_.store(futures.size());
+	for (size_t i = 0; i < futures.size(); ++i)
+	{
+		futures[i].onReady([context, i](Future<T>&& ready) {
+			try
+			{
+				context->values_[i].value_ = ready.get();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(context->mutex_);
+				if (!context->exception_)
+					context->exception_ = std::current_exception();
+			}
+			if (context->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				if (context->exception_)
+					context->promise_.setException(context->exception_);
+				else
+				{
+					std::vector<T> values;
+					values.reserve(context->count_);
+					for (size_t j = 0; j < context->count_; ++j)
+						values.push_back(std::move(context->values_[j].value_));
+					context->promise_.setValue(std::move(values));
+				}
+			}
+		});
+	}
+	return future;
+}
+
+inline Future<void> whenAll(std::vector<Future<void>> futures)
+{
+	struct Context
+	{
+		std::atomic<size_t> remaining_;
+		std::mutex mutex_;
+		std::exception_ptr exception_;
+		Promise<void> promise_;
+	};
+	auto context = std::make_shared<Context>();
+	auto future = context->promise_.getFuture();
+	if (futures.empty())
+	{
+		context->promise_.setValue();
+		return future;
+	}
+	context->remaining_.store(futures.size());
+	for (auto& f : futures)
+	{
+		f.onReady([context](Future<void>&& ready) {
+			try
+			{
+				ready.get();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(context->mutex_);
+				if (!context->exception_)
+					context->exception_ = std::current_exception();
+			}
+			if (context->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				if (context->exception_)
+					context->promise_.setException(context->exception_);
+				else
+					context->promise_.setValue();
+			}
+		});
+	}
+	return future;
+}
+
+END_NAMESPACE(xiao)
@@ -0,0 +1,191 @@
+/**
+ * @file   InlineTask.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/xiao_marco.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <assert.h>
+
+BEGIN_NAMESPACE(xiao)
+
+static constexpr size_t xTaskInlineSize{ 64 };
+
+/**
+ * @brief This class template represents a move-only task. A callable object
+ * no larger than InlineSize bytes (and nothrow movable) is stored in the
+ * inline buffer, so constructing, moving and running the task doesn't
+ * allocate. Larger callables are stored on the heap.
+ */
+template <size_t InlineSize>
+class InlineTask
+{
+public:
+	InlineTask() noexcept = default;
+
+	template <typename F,
+		typename = typename std::enable_if<!std::is_same<
+		typename std::decay<F>::type, InlineTask>::value>::type>
+	explicit InlineTask(F&& f)
+	{
+		using Functor = typename std::decay<F>::type;
+		construct<Functor>(std::forward<F>(f),
+			std::integral_constant<bool, fitsInline<Functor>()>());
+	}
+
+	InlineTask(InlineTask&& other) noexcept
+	{
+		if (other.ops_)
+		{
+			other.ops_->move(&storage_, &other.storage_);
+			ops_ = other.ops_;
+			other.ops_ = nullptr;
+		}
+	}
+
+	InlineTask& operator=(InlineTask&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			if (other.ops_)
+			{
+				other.ops_->move(&storage_, &other.storage_);
+				ops_ = other.ops_;
+				other.ops_ = nullptr;
+			}
+		}
+		return *this;
+	}
+
+	InlineTask(const InlineTask&) = delete;
+	InlineTask& operator=(const InlineTask&) = delete;
+
+	~InlineTask()
+	{
+		reset();
+	}
+
+	void operator()()
+	{
+		assert(ops_);
+		ops_->invoke(&storage_);
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return ops_ != nullptr;
+	}
+
+	void reset() noexcept
+	{
+		if (ops_)
+		{
+			ops_->destroy(&storage_);
+			ops_ = nullptr;
+		}
+	}
+
+	/**
+	 * @brief Return true if a callable of type F is stored without heap
+	 * allocation.
+	 */
+	template <typename F>
+	static constexpr bool fitsInline()
+	{
+		return sizeof(F) <= InlineSize &&
+			alignof(F) <= alignof(std::max_align_t) &&
+			std::is_nothrow_move_constructible<F>::value;
+	}
+
+private:
+	struct Ops
+	{
+		void (*invoke)(void*);
+		void (*move)(void* dst, void* src) noexcept;
+		void (*destroy)(void*) noexcept;
+	};
+
+	template <typename F>
+	struct InlineOps
+	{
+		static void invoke(void* p)
+		{
+			(*static_cast<F*>(p))();
+		}
+		static void move(void* dst, void* src) noexcept
+		{
+			new (dst) F(std::move(*static_cast<F*>(src)));
+			static_cast<F*>(src)->~F();
+		}
+		static void destroy(void* p) noexcept
+		{
+			static_cast<F*>(p)->~F();
+		}
+		static const Ops ops;
+	};
+
+	template <typename F>
+	struct HeapOps
+	{
+		static void invoke(void* p)
+		{
+			(**static_cast<F**>(p))();
+		}
+		static void move(void* dst, void* src) noexcept
+		{
+			*static_cast<F**>(dst) = *static_cast<F**>(src);
+		}
+		static void destroy(void* p) noexcept
+		{
+			delete *static_cast<F**>(p);
+		}
+		static const Ops ops;
+	};
+
+	template <typename Functor, typename F>
+	void construct(F&& f, std::true_type)
+	{
+		new (&storage_) Functor(std::forward<F>(f));
+		ops_ = &InlineOps<Functor>::ops;
+	}
+
+	template <typename Functor, typename F>
+	void construct(F&& f, std::false_type)
+	{
+		*reinterpret_cast<Functor**>(&storage_) =
+			new Functor(std::forward<F>(f));
+		ops_ = &HeapOps<Functor>::ops;
+	}
+
+	static_assert(InlineSize >= sizeof(void*),
+		"The inline buffer must be able to hold a pointer");
+	typename std::aligned_storage<InlineSize, alignof(std::max_align_t)>::type
+		storage_;
+	const Ops* ops_{ nullptr };
+};
+
+template <size_t InlineSize>
+template <typename F>
+const typename InlineTask<InlineSize>::Ops
+InlineTask<InlineSize>::InlineOps<F>::ops = { &InlineOps<F>::invoke,
+											 &InlineOps<F>::move,
+											 &InlineOps<F>::destroy };
+
+template <size_t InlineSize>
+template <typename F>
+const typename InlineTask<InlineSize>::Ops
+InlineTask<InlineSize>::HeapOps<F>::ops = { &HeapOps<F>::invoke,
+										   &HeapOps<F>::move,
+										   &HeapOps<F>::destroy };
+
+using SmallTask = InlineTask<xTaskInlineSize>;
+
+END_NAMESPACE(xiao)
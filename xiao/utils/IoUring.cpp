@@ -0,0 +1,253 @@
+/**
+ * @file   IoUring.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/utils/IoUring.h>
+#ifdef XIAO_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+using namespace xiao;
+
+#ifdef XIAO_HAS_IO_URING
+
+BEGIN_NAMESPACE(xiao)
+static int ioUringSetup(unsigned entries, struct io_uring_params* params)
+{
+	return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete)
+{
+	unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+	return static_cast<int>(::syscall(
+		__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+template <typename T>
+static T* ringPtr(void* ring, uint32_t offset)
+{
+	return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+}
+END_NAMESPACE(xiao)
+
+IoUring::IoUring(unsigned entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = ioUringSetup(entries, &params);
+	if (fd < 0)
+		return;
+
+	sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqRingSize_ =
+		params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMmap)
+	{
+		if (cqRingSize_ > sqRingSize_)
+			sqRingSize_ = cqRingSize_;
+		cqRingSize_ = sqRingSize_;
+	}
+	sqRing_ = ::mmap(nullptr,
+					 sqRingSize_,
+					 PROT_READ | PROT_WRITE,
+					 MAP_SHARED | MAP_POPULATE,
+					 fd,
+					 IORING_OFF_SQ_RING);
+	if (sqRing_ == MAP_FAILED)
+	{
+		sqRing_ = nullptr;
+		::close(fd);
+		return;
+	}
+	if (singleMmap)
+	{
+		cqRing_ = sqRing_;
+	}
+	else
+	{
+		cqRing_ = ::mmap(nullptr,
+						 cqRingSize_,
+						 PROT_READ | PROT_WRITE,
+						 MAP_SHARED | MAP_POPULATE,
+						 fd,
+						 IORING_OFF_CQ_RING);
+		if (cqRing_ == MAP_FAILED)
+		{
+			cqRing_ = nullptr;
+			::munmap(sqRing_, sqRingSize_);
+			sqRing_ = nullptr;
+			::close(fd);
+			return;
+		}
+	}
+	sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+	void* sqes = ::mmap(nullptr,
+						sqesSize_,
+						PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_POPULATE,
+						fd,
+						IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		if (cqRing_ != sqRing_)
+			::munmap(cqRing_, cqRingSize_);
+		::munmap(sqRing_, sqRingSize_);
+		sqRing_ = cqRing_ = nullptr;
+		::close(fd);
+		return;
+	}
+	sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+	sqEntries_ = params.sq_entries;
+	sqHead_ = ringPtr<unsigned>(sqRing_, params.sq_off.head);
+	sqTail_ = ringPtr<unsigned>(sqRing_, params.sq_off.tail);
+	sqMask_ = ringPtr<unsigned>(sqRing_, params.sq_off.ring_mask);
+	sqArray_ = ringPtr<unsigned>(sqRing_, params.sq_off.array);
+	cqHead_ = ringPtr<unsigned>(cqRing_, params.cq_off.head);
+	cqTail_ = ringPtr<unsigned>(cqRing_, params.cq_off.tail);
+	cqMask_ = ringPtr<unsigned>(cqRing_, params.cq_off.ring_mask);
+	cqes_ = ringPtr<void>(cqRing_, params.cq_off.cqes);
+	sqeHead_ = sqeTail_ = *sqTail_;
+	ringFd_ = fd;
+}
+
+IoUring::~IoUring()
+{
+	if (ringFd_ < 0)
+		return;
+	::munmap(sqes_, sqesSize_);
+	if (cqRing_ != sqRing_)
+		::munmap(cqRing_, cqRingSize_);
+	::munmap(sqRing_, sqRingSize_);
+	::close(ringFd_);
+}
+
+struct io_uring_sqe* IoUring::getSqe()
+{
+	unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+	if (sqeTail_ - head >= sqEntries_)
+		return nullptr;
+	auto sqe = &sqes_[sqeTail_ & *sqMask_];
+	++sqeTail_;
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+bool IoUring::prepareWritev(int fd,
+							const struct iovec* vecs,
+							unsigned count,
+							uint64_t offset,
+							uint64_t userData,
+							unsigned flags)
+{
+	auto sqe = getSqe();
+	if (!sqe)
+		return false;
+	++inflight_;
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uint64_t>(vecs);
+	sqe->len = count;
+	sqe->off = offset;
+	sqe->flags = static_cast<uint8_t>(flags);
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareFsync(int fd, uint64_t userData, unsigned flags)
+{
+	auto sqe = getSqe();
+	if (!sqe)
+		return false;
+	++inflight_;
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = fd;
+	sqe->flags = static_cast<uint8_t>(flags);
+	sqe->user_data = userData;
+	return true;
+}
+
+int IoUring::submit(unsigned waitNum)
+{
+	unsigned mask = *sqMask_;
+	for (unsigned i = sqeHead_; i != sqeTail_; ++i)
+	{
+		sqArray_[i & mask] = i & mask;
+	}
+	sqeHead_ = sqeTail_;
+	__atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+	// The kernel may consume fewer entries than passed (or none on EAGAIN or
+	// EBUSY), the ones left in the ring are passed again by the next call.
+	unsigned toSubmit =
+		sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+	if (toSubmit == 0 && waitNum == 0)
+		return 0;
+	int ret;
+	do
+	{
+		ret = ioUringEnter(ringFd_, toSubmit, waitNum);
+	} while (ret < 0 && errno == EINTR);
+	return ret < 0 ? -errno : ret;
+}
+
+bool IoUring::peekCompletion(uint64_t& userData, int& result)
+{
+	unsigned head = *cqHead_;
+	if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+		return false;
+	auto cqe = static_cast<struct io_uring_cqe*>(cqes_) + (head & *cqMask_);
+	userData = cqe->user_data;
+	result = cqe->res;
+	__atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+	--inflight_;
+	return true;
+}
+
+#else  // XIAO_HAS_IO_URING
+
+IoUring::IoUring(unsigned)
+{
+}
+
+IoUring::~IoUring()
+{
+}
+
+bool IoUring::prepareWritev(int,
+							const struct iovec*,
+							unsigned,
+							uint64_t,
+							uint64_t,
+							unsigned)
+{
+	return false;
+}
+
+bool IoUring::prepareFsync(int, uint64_t, unsigned)
+{
+	return false;
+}
+
+int IoUring::submit(unsigned)
+{
+	return -1;
+}
+
+bool IoUring::peekCompletion(uint64_t&, int&)
+{
+	return false;
+}
+
+#endif  // XIAO_HAS_IO_URING
@@ -0,0 +1,111 @@
+/**
+ * @file   IoUring.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/exports.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define XIAO_HAS_IO_URING 1
+#endif
+#endif
+
+struct iovec;
+struct io_uring_sqe;
+
+BEGIN_NAMESPACE(xiao)
+
+/**
+ * @brief This class is a minimal io_uring instance driven by the raw system
+ * calls, so no library is needed. It is used by one thread only. If the
+ * kernel lacks io_uring (or it is disabled), valid() returns false and the
+ * caller should fall back to synchronous system calls.
+ */
+class XIAO_EXPORT IoUring : public NonCopyable
+{
+public:
+	explicit IoUring(unsigned entries);
+	~IoUring();
+
+	bool valid() const
+	{
+		return ringFd_ >= 0;
+	}
+
+	/**
+	 * @brief Queue a writev at the given offset, the request is sent to the
+	 * kernel by submit(). The iovec array must stay valid until the request
+	 * completes.
+	 *
+	 * \param flags The IOSQE_* flags of the request.
+	 * \return false if the submission queue is full.
+	 */
+	bool prepareWritev(int fd,
+					   const struct iovec* vecs,
+					   unsigned count,
+					   uint64_t offset,
+					   uint64_t userData,
+					   unsigned flags = 0);
+
+	bool prepareFsync(int fd, uint64_t userData, unsigned flags = 0);
+
+	/**
+	 * @brief Send the queued requests to the kernel and wait for at least
+	 * waitNum completions.
+	 *
+	 * \return The number of requests consumed by the kernel or -errno, the
+	 * requests not consumed stay queued and are sent by the next call.
+	 */
+	int submit(unsigned waitNum = 0);
+
+	/**
+	 * @brief Take one completion without blocking.
+	 */
+	bool peekCompletion(uint64_t& userData, int& result);
+
+	/**
+	 * @brief Return the number of requests prepared and not completed yet.
+	 */
+	size_t inflight() const
+	{
+		return inflight_;
+	}
+
+private:
+	struct io_uring_sqe* getSqe();
+
+	int ringFd_{ -1 };
+	unsigned sqEntries_{ 0 };
+	void* sqRing_{ nullptr };
+	void* cqRing_{ nullptr };
+	size_t sqRingSize_{ 0 };
+	size_t cqRingSize_{ 0 };
+	struct io_uring_sqe* sqes_{ nullptr };
+	size_t sqesSize_{ 0 };
+
+	unsigned* sqHead_{ nullptr };
+	unsigned* sqTail_{ nullptr };
+	unsigned* sqMask_{ nullptr };
+	unsigned* sqArray_{ nullptr };
+	unsigned* cqHead_{ nullptr };
+	unsigned* cqTail_{ nullptr };
+	unsigned* cqMask_{ nullptr };
+	void* cqes_{ nullptr };
+
+	// the requests prepared and not published to the kernel yet are
+	// [sqeHead_, sqeTail_), the ones published and not consumed by the
+	// kernel are [*sqHead_, sqeHead_)
+	unsigned sqeHead_{ 0 };
+	unsigned sqeTail_{ 0 };
+	size_t inflight_{ 0 };
+};
+
+END_NAMESPACE(xiao)
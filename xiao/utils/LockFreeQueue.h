@@ -8,19 +8,32 @@
 #pragma once
 
 #include <xiao/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 BEGIN_NAMESPACE(xiao)
 
 /**
  * @brief This class template represents a lock-free multiple producers single
- * consumer queue
+ * consumer queue. The element is stored inline in the node, and the nodes
+ * released by the consumer are recycled through a lock-free free list, so a
+ * steady stream of enqueue/dequeue pairs does not allocate. The free list
+ * keeps as many nodes as the peak number of elements in the queue until the
+ * queue is destroyed. A node whose address doesn't fit in the pointer bits of
+ * the tagged free list head (e.g. with 5-level paging or tagged pointers) is
+ * not recycled, it is deleted by the consumer instead.
  */
 template <typename T>
 class MpscQueue : public NonCopyable
 {
 public:
 	MpscQueue()
-		: head_(new BufferNode), tail_(head_.load(std::memory_order_relaxed))
+		: head_(newNode()), tail_(head_.load(std::memory_order_relaxed))
 	{
 	}
 	~MpscQueue()
@@ -31,63 +44,562 @@ public:
 		}
 		BufferNode* front = head_.load(std::memory_order_relaxed);
 		delete front;
+		BufferNode* node = pointerOf(freeList_.load(std::memory_order_relaxed));
+		while (node)
+		{
+			BufferNode* next = node->freeNext_.load(std::memory_order_relaxed);
+			delete node;
+			node = next;
+		}
 	}
 
 	void enqueue(T&& input)
 	{
-		BufferNode* node{ new BufferNode(std::move(input)) };
+		BufferNode* node{ allocNode() };
+		new (node->dataPtr()) T(std::move(input));
 		BufferNode* prevhead{ head_.exchange(node, std::memory_order_acq_rel) };
 		prevhead->next_.store(node, std::memory_order_release);
 	}
 	void enqueue(const T& input)
 	{
-		BufferNode* node{ new BufferNode(input) };
-		BufferNode* prevhead{ head_.exchange(node, std; :memory_order::acq_rel) };
+		BufferNode* node{ allocNode() };
+		new (node->dataPtr()) T(input);
+		BufferNode* prevhead{ head_.exchange(node, std::memory_order_acq_rel) };
 		prevhead->next_.store(node, std::memory_order_release);
 	}
 
 	bool dequeue(T& output)
 	{
 		BufferNode* tail = tail_.load(std::memory_order_relaxed);
-		BufferNode* next = tail_->next_.load(std::memory_order_acquire);
+		BufferNode* next = tail->next_.load(std::memory_order_acquire);
 
 		if (next == nullptr)
 		{
 			return false;
 		}
-		output = std::move(*(next->dataPtr_));
-		delete next->dataPtr_;
+		// next becomes the dummy node, its element is destroyed here and the
+		// old dummy node goes back to the free list.
+		T* data = next->dataPtr();
+		output = std::move(*data);
+		data->~T();
 		tail_.store(next, std::memory_order_release);
-		delete tail;
+		freeNode(tail);
 		return true;
 	}
 
 	bool empty()
 	{
 		BufferNode* tail = tail_.load(std::memory_order_relaxed);
-		BufferNode* next = tail_->next_.load(std; :memory_order::acquire);
+		BufferNode* next = tail->next_.load(std::memory_order_acquire);
 		return next == nullptr;
 	}
 
 private:
 	struct BufferNode
 	{
-		BufferNode() = default;
-		BufferNode(const T& data) :dataPtr_(new T(data))
-		{
-		}
-		BufferNode(T&& data) : dataPtr_(new T(std::move(data)))
+		T* dataPtr()
 		{
+			return reinterpret_cast<T*>(&data_);
 		}
-		T * dataPtr_;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type data_;
 		std::atomic<BufferNode*> next_{ nullptr };
+		std::atomic<BufferNode*> freeNext_{ nullptr };
+		// false if the node can't be packed into the free list head
+		bool pooled_{ true };
 	};
 
+	// The head of the free list is a node pointer packed with a tag. The tag
+	// is increased by every pop, so a producer that read a stale head can not
+	// pop it successfully (ABA). Nodes are only deleted in the destructor, so
+	// reading freeNext_ of a stale head is always safe.
+	using TaggedPtr = uint64_t;
+	static constexpr int xTagShift = sizeof(void*) == 8 ? 48 : 32;
+	static constexpr uint64_t xPointerMask = (uint64_t(1) << xTagShift) - 1;
+
+	static BufferNode* pointerOf(TaggedPtr tagged)
+	{
+		return reinterpret_cast<BufferNode*>(
+			static_cast<uintptr_t>(tagged & xPointerMask));
+	}
+	static TaggedPtr makeTagged(BufferNode* node, uint64_t tag)
+	{
+		return (tag << xTagShift) | static_cast<uint64_t>(
+			reinterpret_cast<uintptr_t>(node));
+	}
+
+	BufferNode* allocNode()
+	{
+		TaggedPtr oldHead = freeList_.load(std::memory_order_acquire);
+		while (BufferNode* node = pointerOf(oldHead))
+		{
+			BufferNode* next = node->freeNext_.load(std::memory_order_relaxed);
+			TaggedPtr newHead = makeTagged(next, (oldHead >> xTagShift) + 1);
+			if (freeList_.compare_exchange_weak(oldHead,
+				newHead,
+				std::memory_order_acquire,
+				std::memory_order_acquire))
+			{
+				node->next_.store(nullptr, std::memory_order_relaxed);
+				return node;
+			}
+		}
+		return newNode();
+	}
+
+	static BufferNode* newNode()
+	{
+		BufferNode* node = new BufferNode;
+		node->pooled_ = (static_cast<uint64_t>(
+			reinterpret_cast<uintptr_t>(node)) & ~xPointerMask) == 0;
+		return node;
+	}
+
+	// Only called by the consumer.
+	void freeNode(BufferNode* node)
+	{
+		if (!node->pooled_)
+		{
+			// no producer can reach the node, it is out of the queue and
+			// never in the free list
+			delete node;
+			return;
+		}
+		TaggedPtr oldHead = freeList_.load(std::memory_order_relaxed);
+		TaggedPtr newHead;
+		do
+		{
+			node->freeNext_.store(pointerOf(oldHead), std::memory_order_relaxed);
+			newHead = makeTagged(node, oldHead >> xTagShift);
+		} while (!freeList_.compare_exchange_weak(oldHead,
+			newHead,
+			std::memory_order_release,
+			std::memory_order_relaxed));
+	}
+
 	std::atomic<BufferNode*> head_;
 	std::atomic<BufferNode*> tail_;
+	std::atomic<TaggedPtr> freeList_{ 0 };
 };
 
 
+static constexpr size_t xCacheLineSize{ 64 };
+
+/**
+ * @brief This class template represents a bounded lock-free multiple producers
+ * multiple consumers queue, based on a ring buffer of sequence-numbered cells
+ * (Dmitry Vyukov's algorithm). The memory footprint is fixed when the queue is
+ * constructed, and a full queue is reported to the producer instead of
+ * growing.
+ */
+template <typename T>
+class MpmcQueue : public NonCopyable
+{
+public:
+	/**
+	 * @brief Construct a new queue.
+	 *
+	 * \param capacity The number of elements the queue can hold. It is
+	 * rounded up to a power of two.
+	 */
+	explicit MpmcQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		mask_ = size - 1;
+		cells_ = std::unique_ptr<Cell[]>(new Cell[size]);
+		for (size_t i = 0; i < size; ++i)
+		{
+			cells_[i].sequence_.store(i, std::memory_order_relaxed);
+		}
+		enqueuePos_.store(0, std::memory_order_relaxed);
+		dequeuePos_.store(0, std::memory_order_relaxed);
+	}
+	~MpmcQueue()
+	{
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		size_t end = enqueuePos_.load(std::memory_order_relaxed);
+		for (; pos != end; ++pos)
+		{
+			cells_[pos & mask_].dataPtr()->~T();
+		}
+	}
+
+	size_t capacity() const
+	{
+		return mask_ + 1;
+	}
+
+	/**
+	 * @brief Try to push an element into the queue.
+	 *
+	 * \return false if the queue is full.
+	 */
+	bool tryPush(T&& input)
+	{
+		return emplace(std::move(input));
+	}
+	bool tryPush(const T& input)
+	{
+		return emplace(input);
+	}
+
+	/**
+	 * @brief Try to pop an element from the queue.
+	 *
+	 * \return false if the queue is empty.
+	 */
+	bool tryPop(T& output)
+	{
+		Cell* cell;
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t seq = cell->sequence_.load(std::memory_order_acquire);
+			intptr_t dif = static_cast<intptr_t>(seq) -
+				static_cast<intptr_t>(pos + 1);
+			if (dif == 0)
+			{
+				if (dequeuePos_.compare_exchange_weak(pos,
+					pos + 1,
+					std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+			}
+		}
+		T* data = cell->dataPtr();
+		output = std::move(*data);
+		data->~T();
+		cell->sequence_.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Try to push up to count elements with one reservation. The
+	 * elements are moved from the range.
+	 *
+	 * \return The number of elements pushed, 0 if the queue is full.
+	 */
+	template <typename Iterator>
+	size_t tryPushBatch(Iterator first, size_t count)
+	{
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		size_t n;
+		for (;;)
+		{
+			n = 0;
+			while (n < count)
+			{
+				size_t seq = cells_[(pos + n) & mask_].sequence_.load(
+					std::memory_order_acquire);
+				if (seq != pos + n)
+					break;
+				++n;
+			}
+			if (n == 0)
+			{
+				size_t seq =
+					cells_[pos & mask_].sequence_.load(std::memory_order_acquire);
+				if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0)
+					return 0;
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (enqueuePos_.compare_exchange_weak(pos,
+				pos + n,
+				std::memory_order_relaxed))
+				break;
+		}
+		for (size_t i = 0; i < n; ++i, ++first)
+		{
+			Cell& cell = cells_[(pos + i) & mask_];
+			new (cell.dataPtr()) T(std::move(*first));
+			cell.sequence_.store(pos + i + 1, std::memory_order_release);
+		}
+		return n;
+	}
+
+	/**
+	 * @brief Try to pop up to count elements with one reservation.
+	 *
+	 * \return The number of elements popped, 0 if the queue is empty.
+	 */
+	template <typename Iterator>
+	size_t tryPopBatch(Iterator first, size_t count)
+	{
+		size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+		size_t n;
+		for (;;)
+		{
+			n = 0;
+			while (n < count)
+			{
+				size_t seq = cells_[(pos + n) & mask_].sequence_.load(
+					std::memory_order_acquire);
+				if (seq != pos + n + 1)
+					break;
+				++n;
+			}
+			if (n == 0)
+			{
+				size_t seq =
+					cells_[pos & mask_].sequence_.load(std::memory_order_acquire);
+				if (static_cast<intptr_t>(seq) -
+					static_cast<intptr_t>(pos + 1) < 0)
+					return 0;
+				pos = dequeuePos_.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (dequeuePos_.compare_exchange_weak(pos,
+				pos + n,
+				std::memory_order_relaxed))
+				break;
+		}
+		for (size_t i = 0; i < n; ++i, ++first)
+		{
+			Cell& cell = cells_[(pos + i) & mask_];
+			T* data = cell.dataPtr();
+			*first = std::move(*data);
+			data->~T();
+			cell.sequence_.store(pos + i + mask_ + 1, std::memory_order_release);
+		}
+		return n;
+	}
+
+	/**
+	 * @brief Return the approximate number of elements in the queue.
+	 */
+	size_t size() const
+	{
+		size_t enq = enqueuePos_.load(std::memory_order_relaxed);
+		size_t deq = dequeuePos_.load(std::memory_order_relaxed);
+		return enq >= deq ? enq - deq : 0;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+private:
+	template <typename U>
+	bool emplace(U&& input)
+	{
+		Cell* cell;
+		size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &cells_[pos & mask_];
+			size_t seq = cell->sequence_.load(std::memory_order_acquire);
+			intptr_t dif =
+				static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (dif == 0)
+			{
+				if (enqueuePos_.compare_exchange_weak(pos,
+					pos + 1,
+					std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueuePos_.load(std::memory_order_relaxed);
+			}
+		}
+		new (cell->dataPtr()) T(std::forward<U>(input));
+		cell->sequence_.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	struct Cell
+	{
+		T* dataPtr()
+		{
+			return reinterpret_cast<T*>(&data_);
+		}
+		std::atomic<size_t> sequence_;
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type data_;
+	};
+
+	// The positions are kept on separate cache lines so that producers and
+	// consumers do not invalidate each other's line.
+	char pad0_[xCacheLineSize];
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_;
+	char pad1_[xCacheLineSize - sizeof(std::unique_ptr<Cell[]>) -
+		sizeof(size_t)];
+	std::atomic<size_t> enqueuePos_;
+	char pad2_[xCacheLineSize - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> dequeuePos_;
+	char pad3_[xCacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+/**
+ * @brief This class template represents a lock-free work-stealing deque
+ * (Chase-Lev). The owner thread pushes and pops elements at the bottom, other
+ * threads steal elements from the top. The buffer grows when it is full, the
+ * old buffers are kept until the deque is destroyed since a thief may still
+ * be reading them. T must be trivially copyable, e.g. a pointer.
+ */
+template <typename T>
+class WorkStealingDeque : public NonCopyable
+{
+public:
+	explicit WorkStealingDeque(size_t capacity = 64)
+	{
+		size_t size = 2;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		buffers_.emplace_back(new Buffer(size));
+		buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Push an element at the bottom. Only the owner can call it.
+	 */
+	void push(T input)
+	{
+		int64_t b = bottom_.load(std::memory_order_relaxed);
+		int64_t t = top_.load(std::memory_order_acquire);
+		Buffer* buf = buffer_.load(std::memory_order_relaxed);
+		if (b - t > buf->mask_)
+		{
+			buf = grow(buf, b, t);
+		}
+		buf->put(b, input);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom_.store(b + 1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Pop an element from the bottom. Only the owner can call it.
+	 *
+	 * \return false if the deque is empty.
+	 */
+	bool pop(T& output)
+	{
+		int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+		Buffer* buf = buffer_.load(std::memory_order_relaxed);
+		bottom_.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top_.load(std::memory_order_relaxed);
+		if (t > b)
+		{
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+		output = buf->get(b);
+		if (t == b)
+		{
+			// the last element, race against the thieves.
+			bool won = top_.compare_exchange_strong(t,
+				t + 1,
+				std::memory_order_seq_cst,
+				std::memory_order_relaxed);
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Steal an element from the top. It can be called from any thread.
+	 *
+	 * \return false if the deque is empty or another thread won the race.
+	 */
+	bool steal(T& output)
+	{
+		int64_t t = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom_.load(std::memory_order_acquire);
+		if (t >= b)
+		{
+			return false;
+		}
+		Buffer* buf = buffer_.load(std::memory_order_acquire);
+		T value = buf->get(t);
+		if (!top_.compare_exchange_strong(t,
+			t + 1,
+			std::memory_order_seq_cst,
+			std::memory_order_relaxed))
+		{
+			return false;
+		}
+		output = value;
+		return true;
+	}
+
+	/**
+	 * @brief Return the approximate number of elements in the deque.
+	 */
+	size_t size() const
+	{
+		int64_t b = bottom_.load(std::memory_order_relaxed);
+		int64_t t = top_.load(std::memory_order_relaxed);
+		return b > t ? static_cast<size_t>(b - t) : 0;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+private:
+	struct Buffer
+	{
+		explicit Buffer(size_t size)
+			: mask_(static_cast<int64_t>(size) - 1),
+			data_(new std::atomic<T>[size])
+		{
+		}
+		T get(int64_t i) const
+		{
+			return data_[i & mask_].load(std::memory_order_relaxed);
+		}
+		void put(int64_t i, T value)
+		{
+			data_[i & mask_].store(value, std::memory_order_relaxed);
+		}
+		const int64_t mask_;
+		std::unique_ptr<std::atomic<T>[]> data_;
+	};
+
+	Buffer* grow(Buffer* old, int64_t b, int64_t t)
+	{
+		Buffer* buf = new Buffer(static_cast<size_t>(old->mask_ + 1) * 2);
+		for (int64_t i = t; i < b; ++i)
+		{
+			buf->put(i, old->get(i));
+		}
+		buffers_.emplace_back(buf);
+		buffer_.store(buf, std::memory_order_release);
+		return buf;
+	}
+
+	char pad0_[xCacheLineSize];
+	std::atomic<int64_t> top_{ 0 };
+	char pad1_[xCacheLineSize - sizeof(std::atomic<int64_t>)];
+	std::atomic<int64_t> bottom_{ 0 };
+	std::atomic<Buffer*> buffer_{ nullptr };
+	// only touched by the owner
+	std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
 END_NAMESPACE(xiao)
 
 
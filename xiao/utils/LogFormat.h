@@ -0,0 +1,798 @@
+/**
+ * @file   LogFormat.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/Logger.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <stdio.h>
+#include <string.h>
+
+BEGIN_NAMESPACE(xiao)
+BEGIN_NAMESPACE(internal)
+
+/**
+ * @brief The format strings of the LOG_*_FMT macros are a subset of the syntax
+ * of std::format, they are parsed and checked against the arguments at
+ * compile time:
+ *
+ *   {} or {:[[fill]align][sign][#][0][width][.precision][type]}
+ *
+ * The arguments are taken in order (no explicit indexes), {{ and }} are the
+ * braces. The types are b, c, d, o, x, X of the integers, e, E, f, F, g, G of
+ * the floating point numbers, s of the strings and bools and p of the
+ * pointers. The arguments of other types are written by operator<< of
+ * LogStream and only take {}.
+ */
+struct FormatSpec
+{
+	char fill_{ ' ' };
+	// '<', '>', '^' or '\0' for the default of the type
+	char align_{ '\0' };
+	// '-', '+' or ' '
+	char sign_{ '-' };
+	bool alternate_{ false };
+	bool zeroPad_{ false };
+	int width_{ 0 };
+	int precision_{ -1 };
+	char type_{ '\0' };
+
+	constexpr bool empty() const
+	{
+		return align_ == '\0' && sign_ == '-' && !alternate_ && !zeroPad_ &&
+			width_ == 0 && precision_ < 0 && type_ == '\0';
+	}
+};
+
+// A literal of the format string and the replacement field after it.
+struct FormatPiece
+{
+	size_t literalBegin_{ 0 };
+	size_t literalLength_{ 0 };
+	bool hasArg_{ false };
+	FormatSpec spec_;
+};
+
+// A format string of K arguments, the argument i goes after the literal
+// [offsets_[i], offsets_[i + 1]) of text_, in which the escaped braces are
+// single.
+template <size_t M, size_t K>
+struct ParsedFormat
+{
+	char text_[M]{};
+	size_t offsets_[K + 2]{};
+	FormatSpec specs_[K + 1];
+};
+
+// The argument types of a log, see formatArgs().
+template <typename... Args>
+struct FormatArgs
+{
+};
+
+// The errors of the format strings, they aren't constexpr so a call to them
+// fails the compilation and its name shows in the error message.
+inline void invalidFormatString()
+{
+}
+inline void tooFewFormatArguments()
+{
+}
+inline void tooManyFormatArguments()
+{
+}
+inline void formatSpecDoesNotMatchArgument()
+{
+}
+
+constexpr bool isFormatAlign(char c)
+{
+	return c == '<' || c == '>' || c == '^';
+}
+
+constexpr bool isFormatDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Return true if type is the default one or one of types.
+constexpr bool isFormatType(char type, const char* types)
+{
+	if (type == '\0')
+		return true;
+	for (; *types; ++types)
+	{
+		if (*types == type)
+			return true;
+	}
+	return false;
+}
+
+constexpr int parseFormatNumber(const char* fmt, size_t& pos)
+{
+	int value = 0;
+	while (isFormatDigit(fmt[pos]))
+	{
+		if (value >= 100000)
+			invalidFormatString();
+		value = value * 10 + (fmt[pos] - '0');
+		++pos;
+	}
+	return value;
+}
+
+// Parse the specification after the ':' of a replacement field, pos is moved
+// to the closing brace.
+constexpr FormatSpec parseFormatSpec(const char* fmt, size_t& pos)
+{
+	FormatSpec spec{};
+	if (fmt[pos] != '\0' && fmt[pos] != '{' && fmt[pos] != '}' &&
+		isFormatAlign(fmt[pos + 1]))
+	{
+		spec.fill_ = fmt[pos];
+		spec.align_ = fmt[pos + 1];
+		pos += 2;
+	}
+	else if (isFormatAlign(fmt[pos]))
+	{
+		spec.align_ = fmt[pos++];
+	}
+	if (fmt[pos] == '+' || fmt[pos] == '-' || fmt[pos] == ' ')
+		spec.sign_ = fmt[pos++];
+	if (fmt[pos] == '#')
+	{
+		spec.alternate_ = true;
+		++pos;
+	}
+	if (fmt[pos] == '0')
+	{
+		spec.zeroPad_ = true;
+		++pos;
+	}
+	spec.width_ = parseFormatNumber(fmt, pos);
+	if (fmt[pos] == '.')
+	{
+		++pos;
+		if (!isFormatDigit(fmt[pos]))
+			invalidFormatString();
+		spec.precision_ = parseFormatNumber(fmt, pos);
+	}
+	if (fmt[pos] != '}' && fmt[pos] != '\0' &&
+		isFormatType(fmt[pos], "bcdoxXeEfFgGsp"))
+		spec.type_ = fmt[pos++];
+	if (fmt[pos] != '}')
+		invalidFormatString();
+	return spec;
+}
+
+// Parse the piece starting at pos, pos is moved to the next one. An escaped
+// brace ends the literal of a piece.
+constexpr FormatPiece nextFormatPiece(const char* fmt, size_t& pos)
+{
+	FormatPiece piece{};
+	piece.literalBegin_ = pos;
+	for (; fmt[pos] != '\0'; ++pos)
+	{
+		char c = fmt[pos];
+		if (c != '{' && c != '}')
+			continue;
+		if (fmt[pos + 1] == c)
+		{
+			piece.literalLength_ = pos + 1 - piece.literalBegin_;
+			pos += 2;
+			return piece;
+		}
+		if (c == '}')
+			invalidFormatString();
+		piece.literalLength_ = pos - piece.literalBegin_;
+		piece.hasArg_ = true;
+		++pos;
+		if (fmt[pos] == ':')
+		{
+			++pos;
+			piece.spec_ = parseFormatSpec(fmt, pos);
+		}
+		else if (fmt[pos] != '}')
+		{
+			invalidFormatString();
+		}
+		++pos;
+		return piece;
+	}
+	piece.literalLength_ = pos - piece.literalBegin_;
+	return piece;
+}
+
+// The category of an argument type: 'b' bool, 'c' char, 'i' integer,
+// 'f' floating point, 's' string, 'p' pointer and 'o' other.
+template <typename T>
+struct FormatCategory
+{
+	static constexpr char value = std::is_same<T, bool>::value ? 'b'
+		: std::is_same<T, char>::value                         ? 'c'
+		: std::is_integral<T>::value                           ? 'i'
+		: std::is_floating_point<T>::value                     ? 'f'
+		: std::is_same<T, const char*>::value ||
+			std::is_same<T, char*>::value ||
+			std::is_same<T, std::string>::value
+		? 's'
+		: std::is_pointer<T>::value &&
+			!std::is_function<typename std::remove_pointer<T>::type>::value
+		? 'p'
+		: 'o';
+};
+
+constexpr bool formatSpecMatches(const FormatSpec& spec, char category)
+{
+	bool plain = spec.sign_ == '-' && !spec.alternate_ && !spec.zeroPad_;
+	switch (category)
+	{
+	case 'i':
+		return spec.precision_ < 0 && isFormatType(spec.type_, "bcdoxX");
+	case 'c':
+		return spec.precision_ < 0 && isFormatType(spec.type_, "bcdoxX") &&
+			(plain || (spec.type_ != '\0' && spec.type_ != 'c'));
+	case 'b':
+		return spec.precision_ < 0 && isFormatType(spec.type_, "s") && plain;
+	case 'f':
+		return isFormatType(spec.type_, "eEfFgG");
+	case 's':
+		return isFormatType(spec.type_, "s") && plain;
+	case 'p':
+		return spec.precision_ < 0 && isFormatType(spec.type_, "p") && plain;
+	default:
+		return spec.empty();
+	}
+}
+
+// Declared only, decltype(formatArgs(fmt, args...)) gives the argument types
+// of a log, the format must be a string literal.
+template <size_t M, typename... Args>
+FormatArgs<typename std::decay<Args>::type...> formatArgs(const char (&fmt)[M],
+	const Args&... args);
+
+template <size_t M, typename... Args>
+constexpr ParsedFormat<M, sizeof...(Args)> parseFormat(const char (&fmt)[M],
+	FormatArgs<Args...>)
+{
+	ParsedFormat<M, sizeof...(Args)> format{};
+	const char categories[] = { FormatCategory<Args>::value..., '\0' };
+	size_t length = 0;
+	size_t arg = 0;
+	size_t pos = 0;
+	do
+	{
+		FormatPiece piece = nextFormatPiece(fmt, pos);
+		for (size_t i = 0; i < piece.literalLength_; ++i)
+			format.text_[length++] = fmt[piece.literalBegin_ + i];
+		if (!piece.hasArg_)
+			continue;
+		if (arg == sizeof...(Args))
+		{
+			tooFewFormatArguments();
+			break;
+		}
+		if (!formatSpecMatches(piece.spec_, categories[arg]))
+			formatSpecDoesNotMatchArgument();
+		format.specs_[arg] = piece.spec_;
+		format.offsets_[++arg] = length;
+	} while (fmt[pos] != '\0');
+	if (arg != sizeof...(Args))
+		tooManyFormatArguments();
+	format.offsets_[sizeof...(Args) + 1] = length;
+	return format;
+}
+
+// Align the len bytes written at p to the width of the spec, the room of the
+// width is reserved at p. The zeros of zeroPad_ go after the prefix (the sign
+// and the base). Return the end of the field.
+inline char* alignFormatted(char* p,
+	size_t len,
+	size_t prefixLength,
+	const FormatSpec& spec,
+	char defaultAlign)
+{
+	size_t width = static_cast<size_t>(spec.width_);
+	if (len >= width)
+		return p + len;
+	size_t padding = width - len;
+	if (spec.zeroPad_ && spec.align_ == '\0')
+	{
+		memmove(p + prefixLength + padding, p + prefixLength, len - prefixLength);
+		memset(p + prefixLength, '0', padding);
+		return p + width;
+	}
+	char align = spec.align_ ? spec.align_ : defaultAlign;
+	size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+	if (before)
+	{
+		memmove(p + before, p, len);
+		memset(p, spec.fill_, before);
+	}
+	memset(p + before + len, spec.fill_, padding - before);
+	return p + width;
+}
+
+template <typename U>
+int countDecimalDigits(U value)
+{
+	int count = 1;
+	for (;;)
+	{
+		if (value < 10)
+			return count;
+		if (value < 100)
+			return count + 1;
+		if (value < 1000)
+			return count + 2;
+		if (value < 10000)
+			return count + 3;
+		value /= 10000u;
+		count += 4;
+	}
+}
+
+// Write the digits of value before end.
+template <typename U>
+void formatDecimal(char* end, U value)
+{
+	while (value >= 100)
+	{
+		size_t i = static_cast<size_t>(value % 100) * 2;
+		value /= 100;
+		end -= 2;
+		end[0] = detail::digitPairs[i];
+		end[1] = detail::digitPairs[i + 1];
+	}
+	if (value >= 10)
+	{
+		size_t i = static_cast<size_t>(value) * 2;
+		end[-2] = detail::digitPairs[i];
+		end[-1] = detail::digitPairs[i + 1];
+	}
+	else
+	{
+		end[-1] = static_cast<char>('0' + value);
+	}
+}
+
+// Write the digits of a base which is a power of 2 at p, shift is the bits of
+// a digit. Return the end.
+template <typename U>
+char* formatPowerOf2(char* p, U value, int shift, const char* digits)
+{
+	char buf[sizeof(U) * 8];
+	char* end = buf + sizeof(buf);
+	char* begin = end;
+	U mask = static_cast<U>((1u << shift) - 1);
+	do
+	{
+		*--begin = digits[value & mask];
+		value = static_cast<U>(value >> shift);
+	} while (value);
+	memcpy(p, begin, static_cast<size_t>(end - begin));
+	return p + (end - begin);
+}
+
+template <typename T>
+bool isNegative(T value, std::true_type)
+{
+	return value < 0;
+}
+template <typename T>
+bool isNegative(T, std::false_type)
+{
+	return false;
+}
+
+template <char C>
+using FormatTag = std::integral_constant<char, C>;
+template <typename T>
+using FormatTagOf =
+	FormatTag<FormatCategory<typename std::decay<T>::type>::value>;
+
+// formatSize() returns the room of an argument, formatArg() writes it there
+// and returns the end.
+
+template <typename T>
+size_t formatSize(const FormatSpec& spec, T, FormatTag<'i'>)
+{
+	// the digits, a sign and the prefix of the base
+	size_t size = spec.type_ == 'b' ? sizeof(T) * 8 + 3 : 25;
+	return (std::max)(static_cast<size_t>(spec.width_), size);
+}
+
+template <typename T>
+char* formatArg(char* p, const FormatSpec& spec, T value, FormatTag<'i'>)
+{
+	if (spec.type_ == 'c')
+	{
+		*p = static_cast<char>(value);
+		return alignFormatted(p, 1, 0, spec, '<');
+	}
+	using U = typename std::make_unsigned<T>::type;
+	char* begin = p;
+	U abs = static_cast<U>(value);
+	if (isNegative(value, std::is_signed<T>()))
+	{
+		*p++ = '-';
+		abs = static_cast<U>(0 - abs);
+	}
+	else if (spec.sign_ != '-')
+	{
+		*p++ = spec.sign_;
+	}
+	if (spec.type_ == '\0' || spec.type_ == 'd')
+	{
+		size_t prefixLength = static_cast<size_t>(p - begin);
+		p += countDecimalDigits(abs);
+		formatDecimal(p, abs);
+		return alignFormatted(
+			begin, static_cast<size_t>(p - begin), prefixLength, spec, '>');
+	}
+	if (spec.alternate_ && (spec.type_ != 'o' || abs != 0))
+	{
+		*p++ = '0';
+		if (spec.type_ != 'o')
+			*p++ = spec.type_;
+	}
+	size_t prefixLength = static_cast<size_t>(p - begin);
+	switch (spec.type_)
+	{
+	case 'x':
+		p = formatPowerOf2(p, abs, 4, "0123456789abcdef");
+		break;
+	case 'X':
+		p = formatPowerOf2(p, abs, 4, "0123456789ABCDEF");
+		break;
+	case 'o':
+		p = formatPowerOf2(p, abs, 3, "01234567");
+		break;
+	default:
+		p = formatPowerOf2(p, abs, 1, "01");
+		break;
+	}
+	return alignFormatted(
+		begin, static_cast<size_t>(p - begin), prefixLength, spec, '>');
+}
+
+inline size_t formatSize(const FormatSpec& spec, char value, FormatTag<'c'>)
+{
+	return formatSize(spec, static_cast<int>(value), FormatTag<'i'>());
+}
+
+inline char* formatArg(char* p, const FormatSpec& spec, char value, FormatTag<'c'>)
+{
+	if (spec.type_ == '\0')
+	{
+		*p = value;
+		return alignFormatted(p, 1, 0, spec, '<');
+	}
+	return formatArg(p, spec, static_cast<int>(value), FormatTag<'i'>());
+}
+
+inline size_t formatSize(const FormatSpec& spec, bool, FormatTag<'b'>)
+{
+	return (std::max)(static_cast<size_t>(spec.width_), size_t{ 5 });
+}
+
+inline char* formatArg(char* p, const FormatSpec& spec, bool value, FormatTag<'b'>)
+{
+	if (value)
+	{
+		memcpy(p, "true", 4);
+		return alignFormatted(p, 4, 0, spec, '<');
+	}
+	memcpy(p, "false", 5);
+	return alignFormatted(p, 5, 0, spec, '<');
+}
+
+// The shortest decimal by default like operator<< of LogStream, snprintf with
+// a precision or a type.
+template <typename T>
+size_t formatSize(const FormatSpec& spec, T value, FormatTag<'f'>)
+{
+	size_t size = 34;
+	if (spec.precision_ >= 0 || spec.type_ != '\0' || spec.alternate_)
+	{
+		size = static_cast<size_t>((std::max)(spec.precision_, 6)) + 32;
+		// the integral digits of %f
+		if ((spec.type_ == 'f' || spec.type_ == 'F') && std::isfinite(value) &&
+			std::fabs(value) >= static_cast<T>(1e16))
+			size += std::numeric_limits<T>::max_exponent10;
+	}
+	return (std::max)(static_cast<size_t>(spec.width_), size);
+}
+
+template <typename T>
+char* formatArg(char* p, const FormatSpec& spec, T value, FormatTag<'f'>)
+{
+	size_t len = 0;
+	if (spec.precision_ < 0 && spec.type_ == '\0' && !spec.alternate_)
+	{
+		if (!std::signbit(value) && spec.sign_ != '-')
+			p[len++] = spec.sign_;
+		using Shortest = typename std::
+			conditional<std::is_same<T, float>::value, float, double>::type;
+		len += detail::formatShortest(p + len, static_cast<Shortest>(value));
+	}
+	else
+	{
+		char format[16];
+		char* f = format;
+		*f++ = '%';
+		if (spec.sign_ != '-')
+			*f++ = spec.sign_;
+		if (spec.alternate_)
+			*f++ = '#';
+		if (spec.precision_ >= 0)
+		{
+			*f++ = '.';
+			f += countDecimalDigits(spec.precision_);
+			formatDecimal(f, spec.precision_);
+		}
+		if (std::is_same<T, long double>::value)
+			*f++ = 'L';
+		*f++ = spec.type_ ? spec.type_ : 'g';
+		*f = '\0';
+		using Promoted = typename std::conditional<
+			std::is_same<T, long double>::value, long double, double>::type;
+		int n = snprintf(p,
+			formatSize(spec, value, FormatTag<'f'>()),
+			format,
+			static_cast<Promoted>(value));
+		len = n > 0 ? static_cast<size_t>(n) : 0;
+	}
+	size_t prefixLength = p[0] == '-' || p[0] == '+' || p[0] == ' ' ? 1 : 0;
+	if (std::isfinite(value) || !spec.zeroPad_)
+		return alignFormatted(p, len, prefixLength, spec, '>');
+	// inf and nan aren't padded with zeros
+	FormatSpec spaced = spec;
+	spaced.zeroPad_ = false;
+	return alignFormatted(p, len, prefixLength, spaced, '>');
+}
+
+inline size_t formatStringLength(const FormatSpec& spec, size_t len)
+{
+	if (spec.precision_ >= 0 && len > static_cast<size_t>(spec.precision_))
+		return static_cast<size_t>(spec.precision_);
+	return len;
+}
+
+inline char* formatString(char* p,
+	const FormatSpec& spec,
+	const char* str,
+	size_t len)
+{
+	len = formatStringLength(spec, len);
+	memcpy(p, str, len);
+	return alignFormatted(p, len, 0, spec, '<');
+}
+
+inline size_t formatSize(const FormatSpec& spec, const char* str, FormatTag<'s'>)
+{
+	return (std::max)(static_cast<size_t>(spec.width_),
+		formatStringLength(spec, str ? strlen(str) : 6));
+}
+
+inline char* formatArg(char* p,
+	const FormatSpec& spec,
+	const char* str,
+	FormatTag<'s'>)
+{
+	if (str)
+		return formatString(p, spec, str, strlen(str));
+	return formatString(p, spec, "(null)", 6);
+}
+
+inline size_t formatSize(const FormatSpec& spec,
+	const std::string& str,
+	FormatTag<'s'>)
+{
+	return (std::max)(static_cast<size_t>(spec.width_),
+		formatStringLength(spec, str.size()));
+}
+
+inline char* formatArg(char* p,
+	const FormatSpec& spec,
+	const std::string& str,
+	FormatTag<'s'>)
+{
+	return formatString(p, spec, str.data(), str.size());
+}
+
+inline size_t formatSize(const FormatSpec& spec, const void*, FormatTag<'p'>)
+{
+	return (std::max)(static_cast<size_t>(spec.width_),
+		2 + sizeof(uintptr_t) * 2);
+}
+
+inline char* formatArg(char* p,
+	const FormatSpec& spec,
+	const void* ptr,
+	FormatTag<'p'>)
+{
+	p[0] = '0';
+	p[1] = 'x';
+	char* end = formatPowerOf2(
+		p + 2, reinterpret_cast<uintptr_t>(ptr), 4, "0123456789abcdef");
+	return alignFormatted(p, static_cast<size_t>(end - p), 0, spec, '>');
+}
+
+template <size_t M, size_t K>
+char* formatLiteral(char* p, const ParsedFormat<M, K>& format, size_t i)
+{
+	size_t len = format.offsets_[i + 1] - format.offsets_[i];
+	memcpy(p, format.text_ + format.offsets_[i], len);
+	return p + len;
+}
+
+constexpr bool isBoundedFormat(const char* categories)
+{
+	for (; *categories; ++categories)
+	{
+		if (*categories == 'o')
+			return false;
+	}
+	return true;
+}
+
+// The room of the whole log is reserved at once and the arguments are
+// written in place.
+template <size_t M, size_t K, size_t... I, typename... Args>
+void formatTo(LogStream& stream,
+	const ParsedFormat<M, K>& format,
+	std::index_sequence<I...>,
+	std::true_type,
+	const Args&... args)
+{
+	size_t sizes[] = { formatSize(format.specs_[I], args, FormatTagOf<Args>())...,
+		format.offsets_[K + 1] };
+	size_t size = 0;
+	for (auto s : sizes)
+		size += s;
+	char* begin = stream.reserve(size);
+	char* p = begin;
+	using Expand = int[];
+	(void)Expand{ 0,
+		(p = formatLiteral(p, format, I),
+			p = formatArg(p, format.specs_[I], args, FormatTagOf<Args>()),
+			0)... };
+	p = formatLiteral(p, format, K);
+	stream.add(static_cast<size_t>(p - begin));
+}
+
+template <typename T, char C>
+void formatArgTo(LogStream& stream,
+	const FormatSpec& spec,
+	const T& arg,
+	FormatTag<C> tag)
+{
+	char* p = stream.reserve(formatSize(spec, arg, tag));
+	stream.add(static_cast<size_t>(formatArg(p, spec, arg, tag) - p));
+}
+
+template <typename T>
+void formatArgTo(LogStream& stream, const FormatSpec&, const T& arg, FormatTag<'o'>)
+{
+	stream << arg;
+}
+
+// Some arguments are written by operator<<.
+template <size_t M, size_t K, size_t... I, typename... Args>
+void formatTo(LogStream& stream,
+	const ParsedFormat<M, K>& format,
+	std::index_sequence<I...>,
+	std::false_type,
+	const Args&... args)
+{
+	using Expand = int[];
+	(void)Expand{ 0,
+		(stream.append(format.text_ + format.offsets_[I],
+			 format.offsets_[I + 1] - format.offsets_[I]),
+			formatArgTo(stream, format.specs_[I], args, FormatTagOf<Args>()),
+			0)... };
+	stream.append(format.text_ + format.offsets_[K],
+		format.offsets_[K + 1] - format.offsets_[K]);
+}
+
+// Write a log of a format parsed by parseFormat() to the stream.
+template <size_t M, size_t K, typename... Args>
+void formatTo(LogStream& stream,
+	const ParsedFormat<M, K>& format,
+	const char (&)[M],
+	const Args&... args)
+{
+	static_assert(K == sizeof...(Args), "the format doesn't match the arguments");
+	constexpr char categories[] = {
+		FormatCategory<typename std::decay<Args>::type>::value..., '\0'
+	};
+	formatTo(stream,
+		format,
+		std::index_sequence_for<Args...>(),
+		std::integral_constant<bool, isBoundedFormat(categories)>(),
+		args...);
+}
+
+END_NAMESPACE(internal)
+
+// LOG_INFO_FMT("x={} y={:.3f}", x, y) writes the arguments directly to the
+// stream of the log, the format string must be a literal, see FormatSpec. A
+// format which doesn't match the arguments fails the compilation, e.g. with
+// a call to tooFewFormatArguments().
+#define XIAO_FMT_EXPAND_(x) x
+#define XIAO_FMT_FIRST_(first, ...) first
+#define XIAO_FMT_STRING_(...) XIAO_FMT_EXPAND_(XIAO_FMT_FIRST_(__VA_ARGS__, ""))
+#define XIAO_LOG_FMT_(stream, ...)                                         \
+  do {                                                                      \
+    static constexpr auto xiaoFormat_ = xiao::internal::parseFormat(       \
+        XIAO_FMT_STRING_(__VA_ARGS__),                                      \
+        decltype(xiao::internal::formatArgs(__VA_ARGS__)){});               \
+    xiao::internal::formatTo((stream), xiaoFormat_, __VA_ARGS__);           \
+  } while (0)
+
+#ifdef NDEBUG
+#define LOG_TRACE_FMT(...)                                                 \
+  XIAO_IF_(0)                                                              \
+  XIAO_LOG_FMT_(                                                           \
+      xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__)     \
+          .stream(),                                                       \
+      __VA_ARGS__)
+#define LOG_TRACE_FMT_TO(index, ...) LOG_TRACE_FMT(__VA_ARGS__)
+#else
+#define LOG_TRACE_FMT(...)                                              \
+  XIAO_SITE_IF_(xiao::Logger::xTrace,                                   \
+                _site->levelEnabled(xiao::Logger::xTrace))              \
+  XIAO_LOG_FMT_(xiao::Logger(*_site, __func__).stream(), __VA_ARGS__)
+#define LOG_TRACE_FMT_TO(index, ...)                                    \
+  XIAO_SITE_IF_(xiao::Logger::xTrace,                                   \
+                _site->levelEnabled(xiao::Logger::xTrace))              \
+  XIAO_LOG_FMT_(xiao::Logger(*_site, __func__).setIndex(index).stream(), \
+                __VA_ARGS__)
+#endif
+#define LOG_DEBUG_FMT(...)                                              \
+  XIAO_SITE_IF_(xiao::Logger::xDebug,                                   \
+                _site->levelEnabled(xiao::Logger::xDebug))              \
+  XIAO_LOG_FMT_(xiao::Logger(*_site, __func__).stream(), __VA_ARGS__)
+#define LOG_DEBUG_FMT_TO(index, ...)                                    \
+  XIAO_SITE_IF_(xiao::Logger::xDebug,                                   \
+                _site->levelEnabled(xiao::Logger::xDebug))              \
+  XIAO_LOG_FMT_(xiao::Logger(*_site, __func__).setIndex(index).stream(), \
+                __VA_ARGS__)
+#define LOG_INFO_FMT(...)                                               \
+  XIAO_SITE_IF_(xiao::Logger::xInfo,                                    \
+                _site->levelEnabled(xiao::Logger::xInfo))               \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).stream(), __VA_ARGS__)
+#define LOG_INFO_FMT_TO(index, ...)                                     \
+  XIAO_SITE_IF_(xiao::Logger::xInfo,                                    \
+                _site->levelEnabled(xiao::Logger::xInfo))               \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).setIndex(index).stream(), __VA_ARGS__)
+#define LOG_WARN_FMT(...)                    \
+  XIAO_SITE_IF_(xiao::Logger::xWarn, true)   \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).stream(), __VA_ARGS__)
+#define LOG_WARN_FMT_TO(index, ...)          \
+  XIAO_SITE_IF_(xiao::Logger::xWarn, true)   \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).setIndex(index).stream(), __VA_ARGS__)
+#define LOG_ERROR_FMT(...)                   \
+  XIAO_SITE_IF_(xiao::Logger::xError, true)  \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).stream(), __VA_ARGS__)
+#define LOG_ERROR_FMT_TO(index, ...)         \
+  XIAO_SITE_IF_(xiao::Logger::xError, true)  \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).setIndex(index).stream(), __VA_ARGS__)
+#define LOG_FATAL_FMT(...)                   \
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true)  \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).stream(), __VA_ARGS__)
+#define LOG_FATAL_FMT_TO(index, ...)         \
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true)  \
+  XIAO_LOG_FMT_(xiao::Logger(*_site).setIndex(index).stream(), __VA_ARGS__)
+
+END_NAMESPACE(xiao)
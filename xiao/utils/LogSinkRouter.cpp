@@ -0,0 +1,302 @@
+/**
+ * @file   LogSinkRouter.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/utils/LogSinkRouter.h>
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+// The header of a log in the queue of a sink, followed by the log.
+struct QueuedLog
+{
+	uint64_t length_;
+	Logger::LogLevel level_;
+};
+
+class LogSinkRouter::Sink : NonCopyable
+{
+public:
+	Sink(OutputFunction outputFunc,
+		FlushFunction flushFunc,
+		const SinkOptions& options)
+		: outputFunc_(std::move(outputFunc)),
+		  flushFunc_(std::move(flushFunc)),
+		  options_(options)
+	{
+		thread_ = std::thread([this]() { threadFunc(); });
+	}
+
+	~Sink()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cond_.notify_one();
+		thread_.join();
+	}
+
+	bool takes(int index, Logger::LogLevel level) const
+	{
+		if (level < options_.minLevel_ || level > options_.maxLevel_)
+			return false;
+		return options_.indexes_.empty() ||
+			std::find(options_.indexes_.begin(),
+				options_.indexes_.end(),
+				index) != options_.indexes_.end();
+	}
+
+	void push(Logger::LogLevel level, const char* msg, const uint64_t len)
+	{
+		QueuedLog header{ len, level };
+		bool wasEmpty;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			wasEmpty = queue_.empty();
+			// a log larger than the queue is taken when the queue is empty
+			if (!wasEmpty &&
+				queue_.size() + sizeof(header) + len > options_.maxQueuedBytes_)
+			{
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				lost_.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			queue_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+			queue_.append(msg, static_cast<size_t>(len));
+			++queuedLogs_;
+		}
+		// the thread only waits when the queue is empty
+		if (wasEmpty)
+			cond_.notify_one();
+	}
+
+	void flush()
+	{
+		// e.g. a fatal log of the output function
+		if (std::this_thread::get_id() == thread_.get_id())
+			return;
+		std::unique_lock<std::mutex> lock(mutex_);
+		uint64_t target = queuedLogs_;
+		flushRequested_ = true;
+		cond_.notify_one();
+		flushedCond_.wait(lock, [this, target]() {
+			return flushedLogs_ >= target || stop_;
+		});
+	}
+
+	uint64_t dropped() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+private:
+	void threadFunc()
+	{
+#ifdef __linux__
+		prctl(PR_SET_NAME, "LogSink");
+#endif
+		std::string writing;
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;)
+		{
+			cond_.wait(lock, [this]() {
+				return stop_ || flushRequested_ || !queue_.empty();
+			});
+			if (stop_ && queue_.empty())
+				break;
+			writing.swap(queue_);
+			uint64_t written = queuedLogs_;
+			bool flushRequested = flushRequested_;
+			flushRequested_ = false;
+			lock.unlock();
+
+			bool flush = writeLogs(writing) || flushRequested;
+			writing.clear();
+			if (flush && flushFunc_)
+				flushFunc_();
+
+			lock.lock();
+			if (flushRequested)
+			{
+				flushedLogs_ = written;
+				flushedCond_.notify_all();
+			}
+		}
+		lock.unlock();
+		if (flushFunc_)
+			flushFunc_();
+		flushedCond_.notify_all();
+	}
+
+	// Return true if an error is written.
+	bool writeLogs(const std::string& logs)
+	{
+		bool error = false;
+		auto lost = lost_.exchange(0, std::memory_order_relaxed);
+		if (lost > 0 && outputFunc_)
+		{
+			char lostMsg[128];
+			auto len = snprintf(lostMsg,
+				sizeof(lostMsg),
+				"%llu log information is lost\n",
+				static_cast<long long unsigned int>(lost));
+			Logger::setOutputLevel(Logger::xWarn);
+			outputFunc_(lostMsg, static_cast<uint64_t>(len));
+		}
+		size_t pos = 0;
+		while (pos < logs.size())
+		{
+			QueuedLog header;
+			memcpy(&header, logs.data() + pos, sizeof(header));
+			pos += sizeof(header);
+			if (outputFunc_)
+			{
+				Logger::setOutputLevel(header.level_);
+				outputFunc_(logs.data() + pos, header.length_);
+			}
+			pos += static_cast<size_t>(header.length_);
+			if (header.level_ >= Logger::xError)
+				error = true;
+		}
+		return error;
+	}
+
+	OutputFunction outputFunc_;
+	FlushFunction flushFunc_;
+	SinkOptions options_;
+	std::mutex mutex_;
+	// wakes the thread of the sink
+	std::condition_variable cond_;
+	std::condition_variable flushedCond_;
+	// QueuedLog headers followed by the logs
+	std::string queue_;
+	uint64_t queuedLogs_{ 0 };
+	uint64_t flushedLogs_{ 0 };
+	bool flushRequested_{ false };
+	bool stop_{ false };
+	std::atomic<uint64_t> dropped_{ 0 };
+	// the logs dropped since the last "lost" message
+	std::atomic<uint64_t> lost_{ 0 };
+	std::thread thread_;
+};
+END_NAMESPACE(xiao)
+
+LogSinkRouter::LogSinkRouter() = default;
+
+LogSinkRouter::~LogSinkRouter() = default;
+
+size_t LogSinkRouter::addSink(OutputFunction outputFunc,
+	FlushFunction flushFunc,
+	const SinkOptions& options)
+{
+	sinks_.emplace_back(
+		new Sink(std::move(outputFunc), std::move(flushFunc), options));
+	return sinks_.size() - 1;
+}
+
+size_t LogSinkRouter::addSink(OutputFunction outputFunc,
+	FlushFunction flushFunc)
+{
+	return addSink(std::move(outputFunc), std::move(flushFunc), SinkOptions());
+}
+
+void LogSinkRouter::attach(int index)
+{
+	// The sinks flush the errors themselves, only a fatal log waits for them.
+	Logger::setOutputFunction(
+		[this, index](const char* msg, const uint64_t len) {
+			output(index, Logger::outputLevel(), msg, len);
+		},
+		[this]() {
+			if (Logger::outputLevel() == Logger::xFatal)
+				flush();
+		},
+		index);
+}
+
+void LogSinkRouter::output(int index,
+	Logger::LogLevel level,
+	const char* msg,
+	const uint64_t len)
+{
+	for (auto& sink : sinks_)
+	{
+		if (sink->takes(index, level))
+			sink->push(level, msg, len);
+	}
+}
+
+void LogSinkRouter::flush()
+{
+	for (auto& sink : sinks_)
+	{
+		sink->flush();
+	}
+}
+
+uint64_t LogSinkRouter::droppedLogs(size_t sink) const
+{
+	return sink < sinks_.size() ? sinks_[sink]->dropped() : 0;
+}
+
+LogRingBuffer::LogRingBuffer(size_t capacity) : data_(capacity)
+{
+}
+
+void LogRingBuffer::output(const char* msg, const uint64_t len)
+{
+	if (data_.empty())
+		return;
+	size_t length = static_cast<size_t>((std::min)(
+		len, static_cast<uint64_t>(data_.size())));
+	std::lock_guard<std::mutex> lock(mutex_);
+	while (length_ + length > data_.size())
+		dropOldest();
+	size_t end = (begin_ + length_) % data_.size();
+	size_t first = (std::min)(length, data_.size() - end);
+	memcpy(&data_[end], msg, first);
+	memcpy(&data_[0], msg + first, length - first);
+	length_ += length;
+	lengths_.push_back(length);
+}
+
+std::string LogRingBuffer::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::string logs(length_, '\0');
+	if (length_ == 0)
+		return logs;
+	size_t first = (std::min)(length_, data_.size() - begin_);
+	memcpy(&logs[0], &data_[begin_], first);
+	memcpy(&logs[first], &data_[0], length_ - first);
+	return logs;
+}
+
+void LogRingBuffer::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	begin_ = 0;
+	length_ = 0;
+	lengths_.clear();
+}
+
+void LogRingBuffer::dropOldest()
+{
+	size_t length = lengths_.front();
+	lengths_.pop_front();
+	begin_ = (begin_ + length) % data_.size();
+	length_ -= length;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file   LogSinkRouter.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/Logger.h>
+#include <xiao/utils/NonCopyable.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+BEGIN_NAMESPACE(xiao)
+
+/**
+ * @brief This class fans the logs out to several sinks, e.g. an
+ * AsyncFileLogger of all the logs, another one of the errors, stdout and a
+ * LogRingBuffer. A log is formatted once, the router copies it to the queue
+ * of every sink which takes its level and index, and every sink is written
+ * by its own thread, so a slow sink doesn't stall the logging threads or the
+ * other sinks. When the queue of a sink is full the new logs of the sink are
+ * dropped and counted.
+ *
+ * The sinks are added before attach(), the router must outlive the logs
+ * passed to it.
+ */
+class XIAO_EXPORT LogSinkRouter : NonCopyable
+{
+public:
+	using OutputFunction =
+		std::function<void(const char* msg, const uint64_t len)>;
+	using FlushFunction = std::function<void()>;
+
+	struct SinkOptions
+	{
+		// the logs out of [minLevel_, maxLevel_] are skipped
+		Logger::LogLevel minLevel_{ Logger::xTrace };
+		Logger::LogLevel maxLevel_{ Logger::xFatal };
+		// the logger indexes taken by the sink (-1 is the default output),
+		// empty for all of them
+		std::vector<int> indexes_;
+		// the max bytes of logs waiting for the sink
+		size_t maxQueuedBytes_{ 16 * 1024 * 1024 };
+	};
+
+	LogSinkRouter();
+	/**
+	 * @brief Write the queued logs and stop the threads of the sinks.
+	 */
+	~LogSinkRouter();
+
+	/**
+	 * @brief Add a sink, return its id. The output function is called by the
+	 * thread of the sink with Logger::outputLevel() set to the level of the
+	 * log, the flush function after the errors and on flush().
+	 */
+	size_t addSink(OutputFunction outputFunc,
+		FlushFunction flushFunc,
+		const SinkOptions& options);
+	size_t addSink(OutputFunction outputFunc, FlushFunction flushFunc);
+
+	/**
+	 * @brief Make the router the output of the logger index, see
+	 * Logger::setOutputFunction().
+	 */
+	void attach(int index = -1);
+
+	/**
+	 * @brief Queue a log to the sinks which take it. It's the output function
+	 * set by attach().
+	 */
+	void output(int index,
+		Logger::LogLevel level,
+		const char* msg,
+		const uint64_t len);
+
+	/**
+	 * @brief Wait for the sinks to write the logs queued so far and flush
+	 * them.
+	 */
+	void flush();
+
+	/**
+	 * @brief Return the number of the logs dropped by the sink because its
+	 * queue was full.
+	 */
+	uint64_t droppedLogs(size_t sink) const;
+
+private:
+	class Sink;
+	std::vector<std::unique_ptr<Sink>> sinks_;
+};
+
+/**
+ * @brief An in-memory sink keeping the latest logs, e.g. to be dumped on a
+ * crash or by a debug endpoint. The older logs are dropped when the capacity
+ * is exceeded, a log longer than the capacity is truncated.
+ */
+class XIAO_EXPORT LogRingBuffer : NonCopyable
+{
+public:
+	explicit LogRingBuffer(size_t capacity = 1024 * 1024);
+
+	void output(const char* msg, const uint64_t len);
+
+	/**
+	 * @brief Return the logs kept, from the oldest.
+	 */
+	std::string snapshot() const;
+
+	void clear();
+
+private:
+	void dropOldest();
+
+	mutable std::mutex mutex_;
+	std::vector<char> data_;
+	// the offset of the oldest log and the bytes kept
+	size_t begin_{ 0 };
+	size_t length_{ 0 };
+	// the lengths of the logs kept, from the oldest
+	std::deque<size_t> lengths_;
+};
+
+END_NAMESPACE(xiao)
@@ -7,7 +7,11 @@
  *********************************************************************/
 
 #include <xiao/utils/LogStream.h>
-
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <type_traits>
 
 using namespace xiao;
 using namespace xiao::detail;
@@ -19,27 +23,54 @@ const char* zero = digits + 9;
 
 const char digitHex[] = "0123456789ABCDEF";
 
+const char digitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Write the digits from the end of a local buffer, two at a time.
 template <typename T>
 size_t convert(char buf[], T value)
 {
-	T i = value;
-	char* p = buf;
-
-	do
+	using U = typename std::make_unsigned<T>::type;
+	U i = static_cast<U>(value);
+	bool negative = value < static_cast<T>(0);
+	if (negative)
+		i = static_cast<U>(U(0) - i);
+
+	char tmp[std::numeric_limits<U>::digits10 + 2];
+	char* end = tmp + sizeof(tmp);
+	char* p = end;
+	while (i >= 100)
 	{
-		int lsd = static_cast<int>(i % 10);
-		i /= 10;
-		*p++ = zero[lsd];
-	} while (i != 0);
-
-	if (value < 0)
+		p -= 2;
+		memcpy(p, &digitPairs[(i % 100) * 2], 2);
+		i /= 100;
+	}
+	if (i >= 10)
 	{
-		*p++ = '-';
+		p -= 2;
+		memcpy(p, &digitPairs[i * 2], 2);
+	}
+	else
+	{
+		*--p = static_cast<char>('0' + i);
 	}
-	*p = '\0';
-	std::reverse(buf, p);
 
-	return p - buf;
+	char* out = buf;
+	if (negative)
+		*out++ = '-';
+	size_t len = static_cast<size_t>(end - p);
+	memcpy(out, p, len);
+	out[len] = '\0';
+	return static_cast<size_t>(out - buf) + len;
 }
 
 size_t convertHex(char buf[], uintptr_t value)
@@ -59,6 +90,422 @@ size_t convertHex(char buf[], uintptr_t value)
 	return p - buf;
 }
 
+// The shortest round-trip formatting of floating point numbers with Grisu2
+// (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with
+// Integers", 2010). The output always reads back as the same number and is
+// the shortest one for more than 99.9% of the numbers.
+struct DiyFp
+{
+	uint64_t f_;
+	int e_;
+};
+
+static DiyFp multiply(const DiyFp& x, const DiyFp& y)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 product =
+		static_cast<unsigned __int128>(x.f_) * static_cast<unsigned __int128>(y.f_);
+	uint64_t high = static_cast<uint64_t>(product >> 64);
+	uint64_t low = static_cast<uint64_t>(product);
+	if (low & (uint64_t(1) << 63))  // rounding
+		++high;
+	return { high, x.e_ + y.e_ + 64 };
+#else
+	const uint64_t mask = 0xFFFFFFFF;
+	const uint64_t a = x.f_ >> 32, b = x.f_ & mask;
+	const uint64_t c = y.f_ >> 32, d = y.f_ & mask;
+	const uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+	tmp += uint64_t(1) << 31;  // rounding
+	return { ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e_ + y.e_ + 64 };
+#endif
+}
+
+static DiyFp normalize(DiyFp x)
+{
+	while (!(x.f_ & (uint64_t(1) << 63)))
+	{
+		x.f_ <<= 1;
+		--x.e_;
+	}
+	return x;
+}
+
+template <typename T>
+struct FloatTraits;
+
+template <>
+struct FloatTraits<double>
+{
+	using Bits = uint64_t;
+	static constexpr int xSignificandSize = 52;
+	static constexpr int xExponentMask = 0x7FF;
+	static constexpr int xExponentBias = 0x3FF + xSignificandSize;
+};
+
+template <>
+struct FloatTraits<float>
+{
+	using Bits = uint32_t;
+	static constexpr int xSignificandSize = 23;
+	static constexpr int xExponentMask = 0xFF;
+	static constexpr int xExponentBias = 0x7F + xSignificandSize;
+};
+
+// The cached powers 10^k for k = -348, -340, ..., 340, normalized to 64 bits.
+static const uint64_t xCachedPowersF[] = {
+	0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+	0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+	0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+	0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+	0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+	0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+	0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+	0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+	0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+	0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+	0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+	0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+	0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+	0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+	0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+	0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+	0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+	0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+	0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+	0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+	0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+	0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+	0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+	0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+	0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+	0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+	0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+	0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+	0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+static const int16_t xCachedPowersE[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+	-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+	-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+	-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+	-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+	109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+	641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+// Return a cached power c = 10^-k such that the exponent of the product of
+// a number of exponent e and c is in [-60, -32].
+static DiyFp cachedPower(int e, int& k)
+{
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int ik = static_cast<int>(dk);
+	if (dk - ik > 0.0)
+		++ik;
+	unsigned index = static_cast<unsigned>((ik >> 3) + 1);
+	k = -(-348 + static_cast<int>(index << 3));
+	return { xCachedPowersF[index], xCachedPowersE[index] };
+}
+
+static const uint64_t xPow10[] = { 1ULL,
+	10ULL,
+	100ULL,
+	1000ULL,
+	10000ULL,
+	100000ULL,
+	1000000ULL,
+	10000000ULL,
+	100000000ULL,
+	1000000000ULL,
+	10000000000ULL,
+	100000000000ULL,
+	1000000000000ULL,
+	10000000000000ULL,
+	100000000000000ULL,
+	1000000000000000ULL,
+	10000000000000000ULL,
+	100000000000000000ULL,
+	1000000000000000000ULL,
+	10000000000000000000ULL };
+
+static int countDigits(uint32_t n)
+{
+	int count = 1;
+	while (count < 10 && n >= xPow10[count])
+		++count;
+	return count;
+}
+
+static void grisuRound(char* buffer,
+	int length,
+	uint64_t delta,
+	uint64_t rest,
+	uint64_t tenKappa,
+	uint64_t distance)
+{
+	while (rest < distance && delta - rest >= tenKappa &&
+		(rest + tenKappa < distance ||
+			distance - rest > rest + tenKappa - distance))
+	{
+		--buffer[length - 1];
+		rest += tenKappa;
+	}
+}
+
+// Generate the digits of the number between low and high (w is the number
+// itself), the result is buffer * 10^k.
+static void digitGen(const DiyFp& w,
+	const DiyFp& high,
+	uint64_t delta,
+	char* buffer,
+	int& length,
+	int& k)
+{
+	const DiyFp one = { uint64_t(1) << -high.e_, high.e_ };
+	const uint64_t distance = high.f_ - w.f_;
+	auto p1 = static_cast<uint32_t>(high.f_ >> -one.e_);
+	uint64_t p2 = high.f_ & (one.f_ - 1);
+	int kappa = countDigits(p1);
+	length = 0;
+	while (kappa > 0)
+	{
+		auto divisor = static_cast<uint32_t>(xPow10[kappa - 1]);
+		uint32_t d = p1 / divisor;
+		p1 %= divisor;
+		if (d || length)
+			buffer[length++] = static_cast<char>('0' + d);
+		--kappa;
+		uint64_t rest = (static_cast<uint64_t>(p1) << -one.e_) + p2;
+		if (rest <= delta)
+		{
+			k += kappa;
+			grisuRound(buffer,
+				length,
+				delta,
+				rest,
+				xPow10[kappa] << -one.e_,
+				distance);
+			return;
+		}
+	}
+	for (;;)
+	{
+		p2 *= 10;
+		delta *= 10;
+		auto d = static_cast<char>(p2 >> -one.e_);
+		if (d || length)
+			buffer[length++] = static_cast<char>('0' + d);
+		p2 &= one.f_ - 1;
+		--kappa;
+		if (p2 < delta)
+		{
+			k += kappa;
+			int index = -kappa;
+			grisuRound(buffer,
+				length,
+				delta,
+				p2,
+				one.f_,
+				index < 20 ? distance * xPow10[index] : 0);
+			return;
+		}
+	}
+}
+
+// value must be positive and finite.
+template <typename T>
+static void grisu2(T value, char* buffer, int& length, int& k)
+{
+	using Traits = FloatTraits<T>;
+	using Bits = typename Traits::Bits;
+	Bits bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const Bits hiddenBit = Bits(1) << Traits::xSignificandSize;
+	const Bits significand = bits & (hiddenBit - 1);
+	const int biasedExponent =
+		static_cast<int>(bits >> Traits::xSignificandSize) & Traits::xExponentMask;
+
+	DiyFp v;
+	bool lowerCloser = false;
+	if (biasedExponent != 0)
+	{
+		v = { significand + hiddenBit, biasedExponent - Traits::xExponentBias };
+		lowerCloser = significand == 0 && biasedExponent > 1;
+	}
+	else
+	{
+		v = { significand, 1 - Traits::xExponentBias };
+	}
+
+	// the boundaries between the number and its neighbours
+	DiyFp high = normalize({ (v.f_ << 1) + 1, v.e_ - 1 });
+	DiyFp low = lowerCloser ? DiyFp{ (v.f_ << 2) - 1, v.e_ - 2 }
+							: DiyFp{ (v.f_ << 1) - 1, v.e_ - 1 };
+	low.f_ <<= low.e_ - high.e_;
+	low.e_ = high.e_;
+
+	const DiyFp c = cachedPower(high.e_, k);
+	const DiyFp w = multiply(normalize(v), c);
+	DiyFp wHigh = multiply(high, c);
+	DiyFp wLow = multiply(low, c);
+	++wLow.f_;
+	--wHigh.f_;
+	digitGen(w, wHigh, wHigh.f_ - wLow.f_, buffer, length, k);
+}
+
+// Lay out the digits (buffer * 10^k) as %g does: without exponent when the
+// decimal exponent is in [-4, 17), e.g. 0.0001, 1.5, 12345678901234567.
+static size_t prettify(char* buffer, int length, int k)
+{
+	const int kk = length + k;  // the position of the decimal point
+	if (length <= kk && kk <= 17)
+	{
+		memset(buffer + length, '0', static_cast<size_t>(kk - length));
+		return static_cast<size_t>(kk);
+	}
+	if (0 < kk && kk <= 17)
+	{
+		memmove(buffer + kk + 1, buffer + kk, static_cast<size_t>(length - kk));
+		buffer[kk] = '.';
+		return static_cast<size_t>(length + 1);
+	}
+	if (-3 <= kk && kk <= 0)
+	{
+		const int offset = 2 - kk;
+		memmove(buffer + offset, buffer, static_cast<size_t>(length));
+		buffer[0] = '0';
+		buffer[1] = '.';
+		memset(buffer + 2, '0', static_cast<size_t>(offset - 2));
+		return static_cast<size_t>(length + offset);
+	}
+	char* p = buffer + 1;
+	if (length > 1)
+	{
+		memmove(buffer + 2, buffer + 1, static_cast<size_t>(length - 1));
+		buffer[1] = '.';
+		p = buffer + length + 1;
+	}
+	int exponent = kk - 1;
+	*p++ = 'e';
+	if (exponent < 0)
+	{
+		*p++ = '-';
+		exponent = -exponent;
+	}
+	else
+	{
+		*p++ = '+';
+	}
+	if (exponent >= 100)
+	{
+		*p++ = static_cast<char>('0' + exponent / 100);
+		exponent %= 100;
+	}
+	memcpy(p, &digitPairs[exponent * 2], 2);
+	p += 2;
+	return static_cast<size_t>(p - buffer);
+}
+
+// buf needs 32 bytes.
+template <typename T>
+size_t convertFloat(char buf[], T value)
+{
+	char* p = buf;
+	if (std::isnan(value))
+	{
+		memcpy(p, "nan", 3);
+		return 3;
+	}
+	if (std::signbit(value))
+	{
+		*p++ = '-';
+		value = -value;
+	}
+	if (std::isinf(value))
+	{
+		memcpy(p, "inf", 3);
+		return static_cast<size_t>(p - buf) + 3;
+	}
+	if (value == 0)
+	{
+		*p = '0';
+		return static_cast<size_t>(p - buf) + 1;
+	}
+	int length, k;
+	grisu2(value, p, length, k);
+	return static_cast<size_t>(p - buf) + prettify(p, length, k);
+}
+
+// The spare buffer of a thread, a stream which overflows takes it and gives it
+// back when it's done. A nested log (e.g. in an operator<< of an argument)
+// of the thread allocates its own buffer.
+struct SpareBuffer
+{
+	~SpareBuffer();
+
+	std::unique_ptr<char[]> data_;
+	size_t capacity_{ 0 };
+};
+
+static thread_local SpareBuffer t_spareBuffer;
+// The logs written by the destructors of other thread_local objects may come
+// after t_spareBuffer is destroyed.
+static thread_local bool t_spareBufferDestroyed{ false };
+
+SpareBuffer::~SpareBuffer()
+{
+	t_spareBufferDestroyed = true;
+}
+
+void OverflowBuffer::grow(size_t len)
+{
+	size_t needed = length_ + len;
+	if (!data_ && !t_spareBufferDestroyed && t_spareBuffer.capacity_ >= needed)
+	{
+		data_ = t_spareBuffer.data_.release();
+		capacity_ = t_spareBuffer.capacity_;
+		t_spareBuffer.capacity_ = 0;
+		return;
+	}
+	size_t capacity = (std::max)(needed, (std::max)(capacity_ * 2, xSmallBuffer * 4));
+	char* data = new char[capacity];
+	if (data_)
+	{
+		memcpy(data, data_, length_);
+		release();
+	}
+	data_ = data;
+	capacity_ = capacity;
+}
+
+void OverflowBuffer::release()
+{
+	if (!t_spareBufferDestroyed && capacity_ <= xMaxSpareBuffer &&
+		capacity_ > t_spareBuffer.capacity_)
+	{
+		t_spareBuffer.data_.reset(data_);
+		t_spareBuffer.capacity_ = capacity_;
+	}
+	else
+	{
+		delete[] data_;
+	}
+	data_ = nullptr;
+	capacity_ = 0;
+}
+
+size_t formatShortest(char* buf, double value)
+{
+	return convertFloat(buf, value);
+}
+
+size_t formatShortest(char* buf, float value)
+{
+	return convertFloat(buf, value);
+}
+
 template class FixedBuffer<xSmallBuffer>;
 template class FixedBuffer<xLargeBuffer>;
 END_NAMESPACE(detail)
@@ -85,23 +532,8 @@ template <typename T>
 void LogStream::formatInteger(T v)
 {
 	constexpr static int xMaxNumericSize = std::numeric_limits<T>::digits10 + 4;
-	if (exBuffer_.empty())
-	{
-		if (buffer_.avail() >= xMaxNumericSize)
-		{
-			size_t len = convert(buffer_.current(), v);
-			buffer_.add(len);
-			return;
-		}
-		else
-		{
-			exBuffer_.append(buffer_.data(), buffer_.length());
-		}
-	}
-	auto oldLen = exBuffer_.length();
-	exBuffer_.resize(oldLen + xMaxNumericSize);
-	size_t len = convert(&exBuffer_[oldLen], v);
-	exBuffer_.resize(oldLen + len);
+	size_t len = convert(reserve(xMaxNumericSize), v);
+	add(len);
 }
 
 LogStream& LogStream::operator<<(short v)
@@ -156,76 +588,47 @@ LogStream& LogStream::operator<<(const void* p)
 {
 	uintptr_t v = reinterpret_cast<uintptr_t>(p);
 	constexpr static int xMaxNumberSize = std::numeric_limits<uintptr_t>::digits / 4 + 4;
-
-	if (exBuffer_.empty())
-	{
-		if (buffer_.avail() >= xMaxNumberSize)
-		{
-			char* buf = buffer_.current();
-			buf[0] = '0';
-			buf[1] = 'x';
-			size_t len = convertHex(buf + 2, v);
-			buffer_.add(len + 2);
-			return *this;
-		}
-		else
-		{
-			exBuffer_.append(buffer_.data(), buffer_.length());
-		}
-	}
-	auto oldLen = exBuffer_.length();
-	exBuffer_.resize(oldLen + xMaxNumberSize);
-	char* buf = &exBuffer_[oldLen];
+	char* buf = reserve(xMaxNumberSize);
 	buf[0] = '0';
 	buf[1] = 'x';
 	size_t len = convertHex(buf + 2, v);
-	exBuffer_.resize(oldLen + len + 2);
+	add(len + 2);
 	return *this;
 }
 
-LogStream& LogStream::operator<<(const double& v)
+template <typename T>
+void LogStream::formatFloat(T v)
 {
 	constexpr static int kMaxNumericSize = 32;
-	if (exBuffer_.empty())
-	{
-		if (buffer_.avail() >= kMaxNumericSize)
-		{
-			int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
-			buffer_.add(len);
-			return *this;
-		}
-		else
-		{
-			exBuffer_.append(buffer_.data(), buffer_.length());
-		}
-	}
-	auto oldLen = exBuffer_.length();
-	exBuffer_.resize(oldLen + kMaxNumericSize);
-	int len = snprintf(&(exBuffer_[oldLen]), kMaxNumericSize, "%.12g", v);
-	exBuffer_.resize(oldLen + len);
+	size_t len = convertFloat(reserve(kMaxNumericSize), v);
+	add(len);
+}
+
+LogStream& LogStream::operator<<(float v)
+{
+	formatFloat(v);
+	return *this;
+}
+
+LogStream& LogStream::operator<<(const double& v)
+{
+	formatFloat(v);
 	return *this;
 }
 
 LogStream& LogStream::operator<<(const long double& v)
 {
-	constexpr static int kMaxNumericSize = 48;
-	if (exBuffer_.empty())
+	// most long doubles hold a double, e.g. the result of a computation
+	// with doubles
+	auto d = static_cast<double>(v);
+	if (static_cast<long double>(d) == v || std::isnan(v))
 	{
-		if (buffer_.avail() >= kMaxNumericSize)
-		{
-			int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12Lg", v);
-			buffer_.add(len);
-			return *this;
-		}
-		else
-		{
-			exBuffer_.append(buffer_.data(), buffer_.length());
-		}
+		formatFloat(d);
+		return *this;
 	}
-	auto oldLen = exBuffer_.length();
-	exBuffer_.resize(oldLen + kMaxNumericSize);
-	int len = snprintf(&(exBuffer_[oldLen]), kMaxNumericSize, "%.12Lg", v);
-	exBuffer_.resize(oldLen + len);
+	constexpr static int kMaxNumericSize = 48;
+	int len = snprintf(reserve(kMaxNumericSize), kMaxNumericSize, "%.12Lg", v);
+	add(len);
 	return *this;
 }
 
@@ -10,11 +10,20 @@
 #include <xiao/utils/NonCopyable.h>
 #include <xiao/exports.h>
 #include <string>
+#include <string.h>
 #include <assert.h>
 
 BEGIN_NAMESPACE(xiao)
 BEGIN_NAMESPACE(detail)
 
+// "00" to "99", for writing two digits at a time
+extern const char digitPairs[201];
+
+// Write the shortest decimal which reads back as the value, in the style of
+// %g, buf needs 32 bytes.
+XIAO_EXPORT size_t formatShortest(char* buf, double value);
+XIAO_EXPORT size_t formatShortest(char* buf, float value);
+
 static constexpr size_t xSmallBuffer{ 4000 };
 static constexpr size_t xLargeBuffer{ 4000 * 1000 };
 
@@ -97,6 +106,69 @@ private:
 	char data_[SIZE];
 	void (*cookie_)();
 };
+
+// The larger buffers are freed instead of being kept for the next message.
+static constexpr size_t xMaxSpareBuffer{ 1024 * 1024 };
+
+// The buffer of the messages which don't fit in the FixedBuffer of a
+// LogStream. Its memory is taken from and given back to a spare buffer of the
+// thread, so the large messages of a thread don't allocate once the spare
+// buffer is large enough.
+class XIAO_EXPORT OverflowBuffer : NonCopyable
+{
+public:
+	OverflowBuffer() = default;
+	~OverflowBuffer()
+	{
+		if (data_)
+			release();
+	}
+
+	// Return true if the buffer isn't in use.
+	bool empty() const
+	{
+		return data_ == nullptr;
+	}
+	const char* data() const
+	{
+		return data_;
+	}
+	size_t length() const
+	{
+		return length_;
+	}
+
+	// Return the room for len more bytes, see add().
+	char* reserve(size_t len)
+	{
+		if (capacity_ - length_ < len)
+			grow(len);
+		return data_ + length_;
+	}
+	void add(size_t len)
+	{
+		length_ += len;
+	}
+	void append(const char* data, size_t len)
+	{
+		memcpy(reserve(len), data, len);
+		length_ += len;
+	}
+	void clear()
+	{
+		if (data_)
+			release();
+		length_ = 0;
+	}
+
+private:
+	void grow(size_t len);
+	void release();
+
+	char* data_{ nullptr };
+	size_t length_{ 0 };
+	size_t capacity_{ 0 };
+};
 END_NAMESPACE(detail)
 
 class XIAO_EXPORT LogStream : NonCopyable
@@ -117,16 +189,14 @@ public:
 	self& operator<<(uint32_t);
 	self& operator<<(long);
 	self& operator<<(unsigned long);
-	self& operator<<(const int64_t&);
-	self& operator<<(const uint64_t&);
+	self& operator<<(const long long&);
+	self& operator<<(const unsigned long long&);
 
 	self& operator<<(const void*);
 
-	self& operator<<(float& v)
-	{
-		*this << static_cast<double>(v);
-		return *this;
-	}
+	// Floating point numbers are written as the shortest decimal which reads
+	// back as the same value, in the style of %g.
+	self& operator<<(float v);
 	self& operator<<(const double&);
 	self& operator<<(const long double& v);
 
@@ -187,6 +257,7 @@ public:
 		{
 			if (!buffer_.append(data, len))
 			{
+				exBuffer_.reserve(buffer_.length() + len);
 				exBuffer_.append(buffer_.data(), buffer_.length());
 				exBuffer_.append(data, len);
 			}
@@ -197,6 +268,27 @@ public:
 		}
 	}
 
+	// Return the room for len more bytes, which are committed by add(), so
+	// the values can be formatted in place.
+	char* reserve(size_t len)
+	{
+		if (exBuffer_.empty())
+		{
+			if (static_cast<size_t>(buffer_.avail()) > len)
+				return buffer_.current();
+			exBuffer_.reserve(buffer_.length() + len);
+			exBuffer_.append(buffer_.data(), buffer_.length());
+		}
+		return exBuffer_.reserve(len);
+	}
+	void add(size_t len)
+	{
+		if (exBuffer_.empty())
+			buffer_.add(len);
+		else
+			exBuffer_.add(len);
+	}
+
 	const char* bufferData() const
 	{
 		if (!exBuffer_.empty())
@@ -222,10 +314,12 @@ public:
 
 private:
 	Buffer buffer_;
-	std::string exBuffer_;
+	detail::OverflowBuffer exBuffer_;
 
 	template <typename T>
 	void formatInteger(T);
+	template <typename T>
+	void formatFloat(T);
 };
 
 class XIAO_EXPORT Fmt
@@ -7,6 +7,9 @@
  */
 
 #include <xiao/utils/Logger.h>
+#include <chrono>
+#include <map>
+#include <mutex>
 #include <thread>
 #ifdef __unix__
 #include <unistd.h>
@@ -20,8 +23,6 @@
 #endif
 #ifdef XIAO_SPDLOG_SUPPORT
 #include <spdlog/spdlog.h>
-#include <map>
-#include <mutex>
 #endif // XIAO_SPDLOG_SUPPORT
 #if (__cplusplus >= 201703L) || \
     (defined(_MSVC_LANG) &&     \
@@ -46,6 +47,8 @@ namespace std
 
 BEGIN_NAMESPACE(xiao)
 
+static thread_local Logger::LogLevel t_outputLevel = Logger::xInfo;
+
 // helper class for known string length at complie time
 class T {
 public:
@@ -81,8 +84,95 @@ END_NAMESPACE(xiao)
 
 using namespace xiao;
 
-static thread_local uint64_t lastSecond_{ 0 };
-static thread_local char lastTimeString_[32]{ 0 };
+static inline void writeTwoDigits(char* p, unsigned value)
+{
+	memcpy(p, &detail::digitPairs[value * 2], 2);
+}
+
+static void writeDate(char* p, int year, unsigned month, unsigned day)
+{
+	writeTwoDigits(p, static_cast<unsigned>(year / 100 % 100));
+	writeTwoDigits(p + 2, static_cast<unsigned>(year % 100));
+	writeTwoDigits(p + 4, month);
+	writeTwoDigits(p + 6, day);
+}
+
+// The date of the day since epoch in the proleptic Gregorian calendar, see
+// http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+static void civilFromDays(int64_t days, int& year, unsigned& month, unsigned& day)
+{
+	days += 719468;
+	const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(days - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp = (5 * doy + 2) / 153;
+	day = doy - (153 * mp + 2) / 5 + 1;
+	month = mp < 10 ? mp + 3 : mp - 9;
+	year = static_cast<int>(static_cast<int64_t>(yoe) + era * 400 +
+		(month <= 2 ? 1 : 0));
+}
+
+// "YYYYmmdd HH:MM:SS" of the logs of a thread, the date and the minute are
+// only formatted again when they roll over.
+struct TimeCache
+{
+	int64_t second_{ -1 };
+	int64_t minute_{ -1 };
+	int64_t day_{ -1 };
+	bool local_{ false };
+	char buf_[17];
+};
+
+static thread_local TimeCache t_timeCache;
+
+// The offsets of the local times are assumed to be whole minutes.
+static void updateTimeCache(TimeCache& cache, int64_t second, bool local)
+{
+	int64_t minute = second / 60;
+	if (minute != cache.minute_ || local != cache.local_)
+	{
+		if (local)
+		{
+			time_t seconds = static_cast<time_t>(second);
+			struct tm tmTime;
+#ifndef _WIN32
+			localtime_r(&seconds, &tmTime);
+#else
+			localtime_s(&tmTime, &seconds);
+#endif  // !_WIN32
+			writeDate(cache.buf_,
+				tmTime.tm_year + 1900,
+				static_cast<unsigned>(tmTime.tm_mon + 1),
+				static_cast<unsigned>(tmTime.tm_mday));
+			writeTwoDigits(cache.buf_ + 9, static_cast<unsigned>(tmTime.tm_hour));
+			writeTwoDigits(cache.buf_ + 12, static_cast<unsigned>(tmTime.tm_min));
+			cache.day_ = -1;
+		}
+		else
+		{
+			int64_t day = second / 86400;
+			if (day != cache.day_)
+			{
+				int year;
+				unsigned month, dayOfMonth;
+				civilFromDays(day, year, month, dayOfMonth);
+				writeDate(cache.buf_, year, month, dayOfMonth);
+				cache.day_ = day;
+			}
+			auto minuteOfDay = static_cast<unsigned>(minute - day * 1440);
+			writeTwoDigits(cache.buf_ + 9, minuteOfDay / 60);
+			writeTwoDigits(cache.buf_ + 12, minuteOfDay % 60);
+		}
+		cache.buf_[8] = ' ';
+		cache.buf_[11] = ':';
+		cache.buf_[14] = ':';
+		cache.minute_ = minute;
+		cache.local_ = local;
+	}
+	writeTwoDigits(cache.buf_ + 15, static_cast<unsigned>(second % 60));
+	cache.second_ = second;
+}
 
 #ifdef __linux__
 static thread_local pid_t threadId_{ 0 };
@@ -91,50 +181,36 @@ static thread_local uint64_t threadId_{ 0 };
 #endif
 
 void Logger::formatTime() {
-	uint64_t now = static_cast<uint64_t>(date_.secondsSinceEpoch());
-	uint64_t microSec = static_cast<uint64_t>(
-		date_.microSecondsSinceEpoch() - date_.roundSecond().microSecondsSinceEpoch());
-	if (now != lastSecond_) {
-		lastSecond_ = now;
-		if (displayLocalTime_()) {
-#ifndef _MSC_VER
-			strncpy(lastTimeString_, date_.toFormattedStringLocal(false).c_str(),
-				sizeof(lastTimeString_) - 1);
-#else
-			strncpy_s<sizeof lastTimeString_>(
-				lastTimeString_, date_.toFormattedStringLocal(false).c_str(),
-				sizeof(lastTimeString_) - 1);
-#endif  // !_MSC_VER
-		}
-		else {
-#ifndef _MSC_VER
-			strncpy(lastTimeString_, date_.toFormattedString(false).c_str(),
-				sizeof(lastTimeString_) - 1);
-#else
-			strncpy_s<sizeof lastTimeString_>(lastTimeString_,
-				date_.toFormattedString(false).c_str(),
-				sizeof(lastTimeString_) - 1);
-#endif  // !_MSC_VER
-		}
-	}
-	logStream_ << T(lastTimeString_, 17);
-	char tmp[32];
-	if (displayLocalTime_())
+	int64_t microSecondsSinceEpoch = date_.microSecondsSinceEpoch();
+	int64_t second = microSecondsSinceEpoch / MICRO_SECONDS_PER_SEC;
+	auto microSec = static_cast<unsigned>(
+		microSecondsSinceEpoch % MICRO_SECONDS_PER_SEC);
+	bool local = displayLocalTime_();
+	auto& cache = t_timeCache;
+	if (second != cache.second_ || local != cache.local_)
+		updateTimeCache(cache, second, local);
+	// "YYYYmmdd HH:MM:SS.uuuuuu UTC "
+	char buf[32];
+	memcpy(buf, cache.buf_, sizeof(cache.buf_));
+	buf[17] = '.';
+	writeTwoDigits(buf + 18, microSec / 10000);
+	writeTwoDigits(buf + 20, microSec / 100 % 100);
+	writeTwoDigits(buf + 22, microSec % 100);
+	if (local)
 	{
-		snprintf(tmp,
-			sizeof(tmp),
-			".%06llu ",
-			static_cast<uint64_t>(microSec));
-		logStream_ << T(tmp, 8);
+		buf[24] = ' ';
+		logStream_.append(buf, 25);
 	}
 	else
 	{
-		snprintf(tmp,
-			sizeof(tmp),
-			".%06llu UTC ",
-			static_cast<uint64_t>(microSec));
-		logStream_ << T(tmp, 12);
+		memcpy(buf + 24, " UTC ", 5);
+		logStream_.append(buf, 29);
 	}
+	logStream_ << threadId();
+}
+
+uint64_t Logger::threadId()
+{
 #ifdef __linux__
 	if (threadId_ == 0)
 		threadId_ = static_cast<pid_t>(::syscall(SYS_gettid));
@@ -166,7 +242,7 @@ void Logger::formatTime() {
 		pthread_threadid_np(NULL, &threadId_);
 	}
 #endif
-	logStream_ << threadId_;
+	return static_cast<uint64_t>(threadId_);
 }
 static const char* logLevelStr[Logger::LogLevel::xNumberofLogLevels] = {
 	" TRACE ",
@@ -177,6 +253,54 @@ static const char* logLevelStr[Logger::LogLevel::xNumberofLogLevels] = {
 	" FATAL ",
 };
 
+Logger::Logger(LogSite& site) : site_(&site), level_(site.level_)
+{
+	if (site.id_.load(std::memory_order_relaxed) == 0)
+		registerSite(site);
+	formatTime();
+	logStream_ << T(logLevelStr[level_], 7);
+#ifdef XIAO_SPDLOG_SUPPORT
+	spdLogMessageOffset_ = logStream_.bufferLength();
+#endif
+	if (site.suppressed_.load(std::memory_order_relaxed) != 0)
+		appendSuppressed(site);
+}
+Logger::Logger(LogSite& site, const char* func)
+	: site_(&site), level_(site.level_)
+#ifdef XIAO_SPDLOG_SUPPORT
+	,
+	func_(func)
+#endif
+{
+	if (site.id_.load(std::memory_order_relaxed) == 0)
+		registerSite(site);
+	formatTime();
+	logStream_ << T(logLevelStr[level_], 7) << "[" << func << "] ";
+#ifdef XIAO_SPDLOG_SUPPORT
+	spdLogMessageOffset_ = logStream_.bufferLength();
+#endif
+	if (site.suppressed_.load(std::memory_order_relaxed) != 0)
+		appendSuppressed(site);
+}
+Logger::Logger(LogSite& site, bool) : site_(&site), level_(site.level_)
+{
+	// registering the site may change errno
+	int savedErrno = errno;
+	if (site.id_.load(std::memory_order_relaxed) == 0)
+		registerSite(site);
+	formatTime();
+	logStream_ << T(logLevelStr[level_], 7);
+#ifdef XIAO_SPDLOG_SUPPORT
+	spdLogMessageOffset_ = logStream_.bufferLength();
+#endif
+	if (site.suppressed_.load(std::memory_order_relaxed) != 0)
+		appendSuppressed(site);
+	if (savedErrno != 0)
+	{
+		logStream_ << strerror_tl(savedErrno) << " (errno=" << savedErrno
+				   << ") ";
+	}
+}
 Logger::Logger(SourceFile file, int line) 
 	: sourceFile_(file), fileLine_(line), level_(xInfo)
 {
@@ -390,6 +514,178 @@ void Logger::disableSpdLog(int index)
 #endif  // TRANTOR_SPDLOG_SUPPORT
 }
 
+struct LogSiteRegistry
+{
+	std::mutex mutex_;
+	std::vector<Logger::LogSite*> sites_;
+	std::map<std::string, Logger::LogLevel> moduleLevels_;
+};
+
+static LogSiteRegistry& logSiteRegistry()
+{
+	static LogSiteRegistry registry;
+	return registry;
+}
+
+// Return the length of the path up to the end of the module if the module is
+// a file or a directory in the path (it matches whole components), otherwise
+// 0. The deeper the module ends in the path, the more specific it is.
+static size_t moduleMatch(const std::string& module, const char* path)
+{
+	size_t match = 0;
+	for (const char* p = strstr(path, module.c_str()); p != nullptr;
+		 p = strstr(p + 1, module.c_str()))
+	{
+		const char* end = p + module.size();
+		if ((p == path || p[-1] == '/' || p[-1] == '\\') &&
+			(*end == '\0' || *end == '/' || *end == '\\'))
+			match = static_cast<size_t>(end - path);
+	}
+	return match;
+}
+
+// Called with the mutex of the registry locked.
+static void resolveSiteLevel(const LogSiteRegistry& registry,
+	Logger::LogSite& site,
+	std::atomic<int>& threshold)
+{
+	Logger::LogLevel level = Logger::logLevel();
+	size_t bestMatch = 0;
+	size_t bestLength = 0;
+	for (auto& moduleLevel : registry.moduleLevels_)
+	{
+		size_t match = moduleMatch(moduleLevel.first, site.path_);
+		// e.g. "xiao/net/EventLoop.cpp" over "EventLoop.cpp" over "xiao/net"
+		if (match > bestMatch ||
+			(match != 0 && match == bestMatch &&
+				moduleLevel.first.size() > bestLength))
+		{
+			level = moduleLevel.second;
+			bestMatch = match;
+			bestLength = moduleLevel.first.size();
+		}
+	}
+	threshold.store(level, std::memory_order_relaxed);
+}
+
+void Logger::registerSite(LogSite& site)
+{
+	auto& registry = logSiteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	if (site.id_.load(std::memory_order_relaxed) != 0)
+		return;
+	resolveSiteLevel(registry, site, site.threshold_);
+	registry.sites_.push_back(&site);
+	site.id_.store(static_cast<uint32_t>(registry.sites_.size()),
+		std::memory_order_release);
+}
+
+bool Logger::LogSite::resolveLevel(LogLevel level)
+{
+	Logger::registerSite(*this);
+	return threshold_.load(std::memory_order_relaxed) <= level;
+}
+
+void Logger::setLogLevel(LogLevel level)
+{
+	auto& registry = logSiteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	logLevel_() = level;
+	for (auto site : registry.sites_)
+	{
+		resolveSiteLevel(registry, *site, site->threshold_);
+	}
+}
+
+static std::string moduleName(const std::string& module)
+{
+	auto end = module.find_last_not_of("/\\");
+	return end == std::string::npos ? std::string() : module.substr(0, end + 1);
+}
+
+void Logger::setModuleLogLevel(const std::string& module, LogLevel level)
+{
+	auto name = moduleName(module);
+	if (name.empty())
+		return;
+	auto& registry = logSiteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	registry.moduleLevels_[name] = level;
+	for (auto site : registry.sites_)
+	{
+		resolveSiteLevel(registry, *site, site->threshold_);
+	}
+}
+
+void Logger::clearModuleLogLevel(const std::string& module)
+{
+	auto& registry = logSiteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	if (registry.moduleLevels_.erase(moduleName(module)) == 0)
+		return;
+	for (auto site : registry.sites_)
+	{
+		resolveSiteLevel(registry, *site, site->threshold_);
+	}
+}
+
+bool Logger::LogSite::perSecond(uint32_t n)
+{
+	if (n == 0)
+	{
+		suppressed_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	// GCRA, the lock-free form of a token bucket: every log moves the
+	// theoretical arrival time by one interval, a log is dropped when it
+	// would be more than one second (n tokens) ahead of now.
+	const int64_t interval = 1000000 / n;
+	const int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch())
+							.count();
+	int64_t next = nextMicroSeconds_.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		int64_t newNext = (next > now ? next : now) + interval;
+		if (newNext - now > 1000000)
+		{
+			suppressed_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		if (nextMicroSeconds_.compare_exchange_weak(next,
+				newNext,
+				std::memory_order_relaxed))
+			return true;
+	}
+}
+
+void Logger::appendSuppressed(LogSite& site)
+{
+	uint64_t suppressed = site.suppressed_.exchange(0, std::memory_order_relaxed);
+	if (suppressed != 0)
+		logStream_ << "(" << suppressed << " suppressed) ";
+}
+
+void Logger::forEachSite(const std::function<void(LogSite& site)>& fn)
+{
+	auto& registry = logSiteRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex_);
+	for (auto site : registry.sites_)
+	{
+		fn(*site);
+	}
+}
+
+Logger::LogLevel Logger::outputLevel()
+{
+	return t_outputLevel;
+}
+
+void Logger::setOutputLevel(LogLevel level)
+{
+	t_outputLevel = level;
+}
+
 RawLogger::~RawLogger()
 {
 #ifdef XIAO_SPDLOG_SUPPORT
@@ -410,20 +706,10 @@ RawLogger::~RawLogger()
 		return;
 	}
 #endif
-	if (index_ < 0)
-	{
-		auto& oFunc = Logger::outputFunc_();
-		if (!oFunc)
-			return;
-		oFunc(logStream_.bufferData(), logStream_.bufferLength());
-	}
-	else
-	{
-		auto& oFunc = Logger::outputFunc_(index_);
-		if (!oFunc)
-			return;
-		oFunc(logStream_.bufferData(), logStream_.bufferLength());
-	}
+	Logger::output(index_,
+		Logger::xInfo,
+		logStream_.bufferData(),
+		logStream_.bufferLength());
 }
 
 Logger::~Logger()
@@ -433,7 +719,9 @@ Logger::~Logger()
 	if (spdLogger)
 	{
 		spdlog::source_loc spdLocation;
-		if (sourceFile_.data_)
+		if (site_)
+			spdLocation = { site_->file_, site_->line_, func_ ? func_ : "" };
+		else if (sourceFile_.data_)
 			spdLocation = { sourceFile_.data_, fileLine_, func_ ? func_ : "" };
 		spdlog::string_view_t message(logStream_.bufferData(),
 			logStream_.bufferLength());
@@ -451,27 +739,40 @@ Logger::~Logger()
 		return;
 	}
 #endif  // TRANTOR_SPDLOG_SUPPORT
-	if (sourceFile_.data_)
+	if (site_)
+		logStream_ << T(" - ", 3)
+				   << T(site_->file_, static_cast<unsigned>(site_->fileLength_))
+				   << ":" << site_->line_ << '\n';
+	else if (sourceFile_.data_)
 		logStream_ << T(" - ", 3) << sourceFile_ << ":" << fileLine_ << '\n';
 	else
 		logStream_ << '\n';
-	if (index_ < 0)
+	output(index_, level_, logStream_.bufferData(), logStream_.bufferLength());
+}
+
+void Logger::output(int index,
+	LogLevel level,
+	const char* msg,
+	const uint64_t len)
+{
+	t_outputLevel = level;
+	if (index < 0)
 	{
 		auto& oFunc = Logger::outputFunc_();
 		if (!oFunc)
 			return;
-		oFunc(logStream_.bufferData(), logStream_.bufferLength());
-		if (level_ >= xError)
+		oFunc(msg, len);
+		if (level >= xError)
 			Logger::flushFunc_()();
 	}
 	else
 	{
-		auto& oFunc = Logger::outputFunc_(index_);
+		auto& oFunc = Logger::outputFunc_(index);
 		if (!oFunc)
 			return;
-		oFunc(logStream_.bufferData(), logStream_.bufferLength());
-		if (level_ >= xError)
-			Logger::flushFunc_(index_)();
+		oFunc(msg, len);
+		if (level >= xError)
+			Logger::flushFunc_(index)();
 	}
 }
 
@@ -12,6 +12,7 @@
 #include <xiao/utils/LogStream.h>
 #include <xiao/utils/NonCopyable.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -70,6 +71,116 @@ class XIAO_EXPORT Logger : public NonCopyable {
     const char* data_;
     int size_;
   };
+
+  /**
+   * @brief The static descriptor of a log statement, every LOG_* macro owns
+   * one (see XIAO_LOG_SITE_). The basename of the source file is found at
+   * compile time and the site gets a stable id when it's used for the first
+   * time, so a log only carries a pointer to its site.
+   */
+  class LogSite {
+   public:
+    constexpr LogSite(const char* file, int line, LogLevel level)
+        : path_(file),
+          file_(basename(file)),
+          fileLength_(length(basename(file))),
+          line_(line),
+          level_(level) {}
+
+    uint32_t id() const { return id_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Return true if a log of the level passes the level of the
+     * module of the site (see setModuleLogLevel), which is cached in the
+     * site, so a disabled site costs one relaxed load.
+     */
+    bool levelEnabled(LogLevel level) {
+      int threshold = threshold_.load(std::memory_order_relaxed);
+      return threshold <= level &&
+             (threshold != xUnresolvedLevel || resolveLevel(level));
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void setEnabled(bool enabled) {
+      enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Return true for the 1st, (n+1)th, (2n+1)th... call, see
+     * LOG_*_EVERY_N.
+     */
+    bool everyN(uint64_t n) {
+      if (n <= 1 || hits_.fetch_add(1, std::memory_order_relaxed) % n == 0)
+        return true;
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    /**
+     * @brief Return true for the first n calls, see LOG_*_FIRST_N. The later
+     * calls only read the counter and aren't counted as suppressed.
+     */
+    bool firstN(uint64_t n) {
+      return hits_.load(std::memory_order_relaxed) < n &&
+             hits_.fetch_add(1, std::memory_order_relaxed) < n;
+    }
+
+    /**
+     * @brief A token bucket of n tokens refilled at n tokens per second, see
+     * LOG_*_RATE.
+     */
+    bool perSecond(uint32_t n);
+
+    /**
+     * @brief The number of logs dropped by everyN() and perSecond() since the
+     * last log of the site, they are reported by the next log.
+     */
+    uint64_t suppressed() const {
+      return suppressed_.load(std::memory_order_relaxed);
+    }
+
+    const char* path_;
+    const char* file_;
+    int fileLength_;
+    int line_;
+    LogLevel level_;
+
+   private:
+    static constexpr int xUnresolvedLevel = -1;
+
+    bool resolveLevel(LogLevel level);
+    static constexpr const char* basename(const char* path) {
+      const char* name = path;
+      for (const char* p = path; *p; ++p) {
+#ifndef _MSC_VER
+        if (*p == '/')
+#else
+        if (*p == '\\' || *p == '/')
+#endif  // !_MSC_VER
+          name = p + 1;
+      }
+      return name;
+    }
+    static constexpr int length(const char* str) {
+      int len = 0;
+      while (str[len]) ++len;
+      return len;
+    }
+
+    friend class Logger;
+    std::atomic<bool> enabled_{true};
+    std::atomic<uint32_t> id_{0};
+    std::atomic<int> threshold_{xUnresolvedLevel};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    // the theoretical arrival time of perSecond() in microseconds
+    std::atomic<int64_t> nextMicroSeconds_{0};
+  };
+
+  Logger(LogSite& site);
+  Logger(LogSite& site, const char* func);
+  Logger(LogSite& site, bool isSysErr);
   Logger(SourceFile file, int line);
   Logger(SourceFile file, int line, LogLevel level);
   Logger(SourceFile file, int line, bool isSysErr);
@@ -98,10 +209,31 @@ class XIAO_EXPORT Logger : public NonCopyable {
     }
   }
 
-  static void setLogLevel(LogLevel level) { logLevel_() = level; }
+  static void setLogLevel(LogLevel level);
 
   static LogLevel logLevel() { return logLevel_(); }
 
+  /**
+   * @brief Set the log level of a module, which overrides the global level
+   * for the TRACE, DEBUG and INFO logs of the module. A module is a source
+   * file or a directory in the path of the source files, e.g. "EventLoop.cpp",
+   * "xiao/net/EventLoop.cpp" or "xiao/net". The most specific module of a
+   * file applies.
+   */
+  static void setModuleLogLevel(const std::string& module, LogLevel level);
+
+  /**
+   * @brief Remove the level of a module set by setModuleLogLevel.
+   */
+  static void clearModuleLogLevel(const std::string& module);
+
+  /**
+   * @brief Return the level of the log being passed to the output function in
+   * the current thread, so that output functions can treat logs by severity.
+   * Raw logs are reported as xInfo.
+   */
+  static LogLevel outputLevel();
+
   static bool displayLocalTime() { return displayLocalTime_(); }
 
   static void setDisplayLocalTime(bool showLocalTime) {
@@ -125,12 +257,26 @@ class XIAO_EXPORT Logger : public NonCopyable {
 
   static std::shared_ptr<spdlog::logger> getDefaultSpdLogger(int index);
 
+  /**
+   * @brief Call fn on every site which has logged so far, in the order of
+   * their ids, e.g. to disable the noisy ones.
+   */
+  static void forEachSite(const std::function<void(LogSite& site)>& fn);
+
  protected:
   static void defaultOutputFunction(const char* msg, const uint64_t len) {
     fwrite(msg, 1, static_cast<size_t>(len), stdout);
   }
   static void defaultFlushFunction() { fflush(stdout); }
   void formatTime();
+  static void registerSite(LogSite& site);
+  void appendSuppressed(LogSite& site);
+  static uint64_t threadId();
+  static void setOutputLevel(LogLevel level);
+  // Pass a complete log to the output function of the index, the errors and
+  // fatal logs are flushed.
+  static void output(int index, LogLevel level, const char* msg,
+                     const uint64_t len);
   static bool& displayLocalTime_() {
     static bool showLocalTime = false;
     return showLocalTime;
@@ -177,8 +323,11 @@ class XIAO_EXPORT Logger : public NonCopyable {
   }
 
   friend class RawLogger;
+  friend class BinaryLogger;
+  friend class LogSinkRouter;
   LogStream logStream_;
   Date date_{Date::now()};
+  LogSite* site_{nullptr};
   SourceFile sourceFile_;
   int fileLine_;
   LogLevel level_;
@@ -201,53 +350,70 @@ class XIAO_EXPORT RawLogger : public NonCopyable {
   int index_{-1};
 };
 
+// The static site of a log statement, the lambda gives every expansion of the
+// macro its own site.
+#define XIAO_LOG_SITE_(level)                                               \
+  ([]() -> xiao::Logger::LogSite& {                                         \
+    static xiao::Logger::LogSite xiaoLogSite_(__FILE__, __LINE__, (level)); \
+    return xiaoLogSite_;                                                    \
+  }())
+#define XIAO_SAMPLED_SITE_IF_(level, cond, sample)                        \
+  for (xiao::Logger::LogSite* _site = &XIAO_LOG_SITE_(level);             \
+       _site != nullptr && (cond) && _site->enabled() && (sample);        \
+       _site = nullptr)
+#define XIAO_SITE_IF_(level, cond) XIAO_SAMPLED_SITE_IF_(level, cond, true)
+
 #ifdef NDEBUG
 #define LOG_TRACE \
   XIAO_IF_(0)     \
   xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__).stream()
 #else
-#define LOG_TRACE                                            \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xTrace) \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__).stream()
-#define LOG_TRACE_TO(index)                                        \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xTrace)       \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__) \
-      .setIndex(index)                                             \
-      .stream()
+#define LOG_TRACE                                          \
+  XIAO_SITE_IF_(xiao::Logger::xTrace,                      \
+                _site->levelEnabled(xiao::Logger::xTrace)) \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_TRACE_TO(index)                                \
+  XIAO_SITE_IF_(xiao::Logger::xTrace,                      \
+                _site->levelEnabled(xiao::Logger::xTrace)) \
+  xiao::Logger(*_site, __func__).setIndex(index).stream()
 #endif
 
-#define LOG_DEBUG                                            \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xDebug) \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xDebug, __func__).stream()
-#define LOG_DEBUG_TO(index)                                           \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xDebug)          \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xDebug, __func__) \
-      .setIndex(index)                                                \
-      .stream()
-#define LOG_INFO                                            \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xInfo) \
-  xiao::Logger(__FILE__, __LINE__).stream()
-#define LOG_INFO_TO(index)                                  \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xInfo) \
-  xiao::Logger(__FILE__, __LINE__).setIndex(index).stream()
-#define LOG_WARN xiao::Logger(__FILE__, __LINE__, xiao::Logger::xWarn).stream()
-#define LOG_WARN_TO(index) \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xWarn).setIndex(index).stream()
+#define LOG_DEBUG                                          \
+  XIAO_SITE_IF_(xiao::Logger::xDebug,                      \
+                _site->levelEnabled(xiao::Logger::xDebug)) \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_DEBUG_TO(index)                                \
+  XIAO_SITE_IF_(xiao::Logger::xDebug,                      \
+                _site->levelEnabled(xiao::Logger::xDebug)) \
+  xiao::Logger(*_site, __func__).setIndex(index).stream()
+#define LOG_INFO                                          \
+  XIAO_SITE_IF_(xiao::Logger::xInfo,                      \
+                _site->levelEnabled(xiao::Logger::xInfo)) \
+  xiao::Logger(*_site).stream()
+#define LOG_INFO_TO(index)                                \
+  XIAO_SITE_IF_(xiao::Logger::xInfo,                      \
+                _site->levelEnabled(xiao::Logger::xInfo)) \
+  xiao::Logger(*_site).setIndex(index).stream()
+#define LOG_WARN \
+  XIAO_SITE_IF_(xiao::Logger::xWarn, true) xiao::Logger(*_site).stream()
+#define LOG_WARN_TO(index)                    \
+  XIAO_SITE_IF_(xiao::Logger::xWarn, true)    \
+  xiao::Logger(*_site).setIndex(index).stream()
 #define LOG_ERROR \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xError).stream()
-#define LOG_ERROR_TO(index)                              \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xError) \
-      .setIndex(index)                                   \
-      .stream()
+  XIAO_SITE_IF_(xiao::Logger::xError, true) xiao::Logger(*_site).stream()
+#define LOG_ERROR_TO(index)                   \
+  XIAO_SITE_IF_(xiao::Logger::xError, true)   \
+  xiao::Logger(*_site).setIndex(index).stream()
 #define LOG_FATAL \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xFatal).stream()
-#define LOG_FATAL_TO(index)                              \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xFatal) \
-      .setIndex(index)                                   \
-      .stream()
-#define LOG_SYSERR xiao::Logger(__FILE__, __LINE__, true).stream()
-#define LOG_SYSERR_TO(index) \
-  xiao::Logger(__FILE__, __LINE__, true).setIndex(index).stream()
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true) xiao::Logger(*_site).stream()
+#define LOG_FATAL_TO(index)                   \
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true)   \
+  xiao::Logger(*_site).setIndex(index).stream()
+#define LOG_SYSERR \
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true) xiao::Logger(*_site, true).stream()
+#define LOG_SYSERR_TO(index)                  \
+  XIAO_SITE_IF_(xiao::Logger::xFatal, true)   \
+  xiao::Logger(*_site, true).setIndex(index).stream()
 
 
 // LOG_COMPACT_... begin block
@@ -280,29 +446,129 @@ class XIAO_EXPORT RawLogger : public NonCopyable {
 #define LOG_RAW xiao::RawLogger().stream()
 #define LOG_RAW_TO(index) xiao::RawLogger().setIndex(index).stream()
 
-#define LOG_TRACE_IF(cond)                                                \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xTrace) && \
-              (cond))                                                     \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__)  \
-      .stream()
-#define LOG_DEBUG_IF(cond)                                                \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xDebug) && \
-              (cond))                                                     \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xDebug, __func__)  \
-      .stream()
-#define LOG_INFO_IF(cond)                                                \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xInfo) && \
-              (cond))                                                    \
-  xiao::Logger(__FILE__, __LINE__).stream()
+#define LOG_TRACE_IF(cond)                                   \
+  XIAO_SITE_IF_(xiao::Logger::xTrace,                        \
+                _site->levelEnabled(xiao::Logger::xTrace) && \
+                    (cond))                                  \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_DEBUG_IF(cond)                                   \
+  XIAO_SITE_IF_(xiao::Logger::xDebug,                        \
+                _site->levelEnabled(xiao::Logger::xDebug) && \
+                    (cond))                                  \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_INFO_IF(cond)                                   \
+  XIAO_SITE_IF_(xiao::Logger::xInfo,                        \
+                _site->levelEnabled(xiao::Logger::xInfo) && \
+                    (cond))                                 \
+  xiao::Logger(*_site).stream()
 #define LOG_WARN_IF(cond) \
-  XIAO_IF_(cond)       \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xWarn).stream()
+  XIAO_SITE_IF_(xiao::Logger::xWarn, cond) xiao::Logger(*_site).stream()
 #define LOG_ERROR_IF(cond) \
-  XIAO_IF_(cond)        \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xError).stream()
+  XIAO_SITE_IF_(xiao::Logger::xError, cond) xiao::Logger(*_site).stream()
 #define LOG_FATAL_IF(cond) \
-  XIAO_IF_(cond)        \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xFatal).stream()
+  XIAO_SITE_IF_(xiao::Logger::xFatal, cond) xiao::Logger(*_site).stream()
+
+// LOG_*_EVERY_N(n) writes the 1st, (n+1)th, (2n+1)th... log of the statement,
+// LOG_*_FIRST_N(n) the first n logs and LOG_*_RATE(nPerSecond) at most
+// nPerSecond logs per second. The counters are per statement and lock-free,
+// the number of the logs dropped by EVERY_N and RATE is written at the
+// beginning of the next log of the statement.
+#ifdef NDEBUG
+#define LOG_TRACE_EVERY_N(n) LOG_TRACE
+#define LOG_TRACE_FIRST_N(n) LOG_TRACE
+#define LOG_TRACE_RATE(nPerSecond) LOG_TRACE
+#else
+#define LOG_TRACE_EVERY_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xTrace,                      \
+                        _site->levelEnabled(xiao::Logger::xTrace), \
+                        _site->everyN(n))                          \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_TRACE_FIRST_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xTrace,                      \
+                        _site->levelEnabled(xiao::Logger::xTrace), \
+                        _site->firstN(n))                          \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_TRACE_RATE(nPerSecond)                                 \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xTrace,                      \
+                        _site->levelEnabled(xiao::Logger::xTrace), \
+                        _site->perSecond(nPerSecond))              \
+  xiao::Logger(*_site, __func__).stream()
+#endif
+#define LOG_DEBUG_EVERY_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xDebug,                      \
+                        _site->levelEnabled(xiao::Logger::xDebug), \
+                        _site->everyN(n))                          \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_DEBUG_FIRST_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xDebug,                      \
+                        _site->levelEnabled(xiao::Logger::xDebug), \
+                        _site->firstN(n))                          \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_DEBUG_RATE(nPerSecond)                                 \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xDebug,                      \
+                        _site->levelEnabled(xiao::Logger::xDebug), \
+                        _site->perSecond(nPerSecond))              \
+  xiao::Logger(*_site, __func__).stream()
+#define LOG_INFO_EVERY_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xInfo,                      \
+                        _site->levelEnabled(xiao::Logger::xInfo), \
+                        _site->everyN(n))                         \
+  xiao::Logger(*_site).stream()
+#define LOG_INFO_FIRST_N(n)                                       \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xInfo,                      \
+                        _site->levelEnabled(xiao::Logger::xInfo), \
+                        _site->firstN(n))                         \
+  xiao::Logger(*_site).stream()
+#define LOG_INFO_RATE(nPerSecond)                                 \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xInfo,                      \
+                        _site->levelEnabled(xiao::Logger::xInfo), \
+                        _site->perSecond(nPerSecond))             \
+  xiao::Logger(*_site).stream()
+#define LOG_WARN_EVERY_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xWarn, \
+                        true,                \
+                        _site->everyN(n))    \
+  xiao::Logger(*_site).stream()
+#define LOG_WARN_FIRST_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xWarn, \
+                        true,                \
+                        _site->firstN(n))    \
+  xiao::Logger(*_site).stream()
+#define LOG_WARN_RATE(nPerSecond)                     \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xWarn,          \
+                        true,                         \
+                        _site->perSecond(nPerSecond)) \
+  xiao::Logger(*_site).stream()
+#define LOG_ERROR_EVERY_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xError, \
+                        true,                 \
+                        _site->everyN(n))     \
+  xiao::Logger(*_site).stream()
+#define LOG_ERROR_FIRST_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xError, \
+                        true,                 \
+                        _site->firstN(n))     \
+  xiao::Logger(*_site).stream()
+#define LOG_ERROR_RATE(nPerSecond)                    \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xError,         \
+                        true,                         \
+                        _site->perSecond(nPerSecond)) \
+  xiao::Logger(*_site).stream()
+#define LOG_FATAL_EVERY_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xFatal, \
+                        true,                 \
+                        _site->everyN(n))     \
+  xiao::Logger(*_site).stream()
+#define LOG_FATAL_FIRST_N(n)                  \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xFatal, \
+                        true,                 \
+                        _site->firstN(n))     \
+  xiao::Logger(*_site).stream()
+#define LOG_FATAL_RATE(nPerSecond)                    \
+  XIAO_SAMPLED_SITE_IF_(xiao::Logger::xFatal,         \
+                        true,                         \
+                        _site->perSecond(nPerSecond)) \
+  xiao::Logger(*_site).stream()
 
 
 #ifdef NDEBUG
@@ -348,47 +614,19 @@ class XIAO_EXPORT RawLogger : public NonCopyable {
   XIAO_IF_(0)            \
   xiao::Logger(__FILE__, __LINE__, xiao::Logger::kFatal).stream()
 #else
-#define DLOG_TRACE                                                       \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xTrace)    \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__) \
-      .stream()
-#define DLOG_DEBUG                                                       \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xDebug)    \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xDebug, __func__) \
-      .stream()
-#define DLOG_INFO                                                    \
-  XIAO_IF_(xiao::Logger::logLevel() <= xiao::Logger::xInfo) \
-  xiao::Logger(__FILE__, __LINE__).stream()
-#define DLOG_WARN \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xWarn).stream()
-#define DLOG_ERROR \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xError).stream()
-#define DLOG_FATAL \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::kFatal).stream()
-
-#define DLOG_TRACE_IF(cond)                                               \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xTrace) && \
-              (cond))                                                     \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xTrace, __func__)  \
-      .stream()
-#define DLOG_DEBUG_IF(cond)                                               \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xDebug) && \
-              (cond))                                                     \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xDebug, __func__)  \
-      .stream()
-#define DLOG_INFO_IF(cond)                                               \
-  XIAO_IF_((xiao::Logger::logLevel() <= xiao::Logger::xInfo) && \
-              (cond))                                                    \
-  xiao::Logger(__FILE__, __LINE__).stream()
-#define DLOG_WARN_IF(cond) \
-  XIAO_IF_(cond)        \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xWarn).stream()
-#define DLOG_ERROR_IF(cond) \
-  XIAO_IF_(cond)         \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::xError).stream()
-#define DLOG_FATAL_IF(cond) \
-  XIAO_IF_(cond)         \
-  xiao::Logger(__FILE__, __LINE__, xiao::Logger::kFatal).stream()
+#define DLOG_TRACE LOG_TRACE
+#define DLOG_DEBUG LOG_DEBUG
+#define DLOG_INFO LOG_INFO
+#define DLOG_WARN LOG_WARN
+#define DLOG_ERROR LOG_ERROR
+#define DLOG_FATAL LOG_FATAL
+
+#define DLOG_TRACE_IF(cond) LOG_TRACE_IF(cond)
+#define DLOG_DEBUG_IF(cond) LOG_DEBUG_IF(cond)
+#define DLOG_INFO_IF(cond) LOG_INFO_IF(cond)
+#define DLOG_WARN_IF(cond) LOG_WARN_IF(cond)
+#define DLOG_ERROR_IF(cond) LOG_ERROR_IF(cond)
+#define DLOG_FATAL_IF(cond) LOG_FATAL_IF(cond)
 #endif
 
 END_NAMESPACE(xiao)
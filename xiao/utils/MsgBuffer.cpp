@@ -8,6 +8,8 @@
 
 #include <xiao/utils/MsgBuffer.h>
 #include <xiao/utils/Funcs.h>
+#include <string.h>
+#include <errno.h>
 #ifndef _WIN32
 #include <sys/uio.h>
 #include <netinet/in.h>
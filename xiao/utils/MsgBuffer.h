@@ -10,6 +10,7 @@
 #include <xiao/utils/NonCopyable.h>
 #include <vector>
 #include <string>
+#include <string.h>
 #include <assert.h>
 #include <algorithm>
 #if defined(_WIN32) && !defined(_SSIZE_T_DEFINED)
@@ -118,7 +119,7 @@ public:
 
 	void retrieve(size_t len);
 
-	size_t readFd(int fd, int* retErrno);
+	ssize_t readFd(int fd, int* retErrno);
 
 	void retrieveUntil(const char* end)
 	{
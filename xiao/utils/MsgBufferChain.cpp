@@ -0,0 +1,177 @@
+/**
+ * @file   MsgBufferChain.cpp
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+
+#include <xiao/utils/MsgBufferChain.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+using namespace xiao;
+
+BEGIN_NAMESPACE(xiao)
+#ifdef IOV_MAX
+static constexpr size_t xMaxIovecs{ IOV_MAX < 64 ? IOV_MAX : 64 };
+#else
+static constexpr size_t xMaxIovecs{ 16 };
+#endif
+END_NAMESPACE(xiao)
+
+MsgBufferChain::MsgBufferChain(size_t blockSize) : blockSize_(blockSize)
+{
+	assert(blockSize_ > 0);
+}
+
+size_t MsgBufferChain::writableBytesInBack() const
+{
+	if (slices_.empty())
+		return 0;
+	auto& back = slices_.back();
+	if (!back.block_)
+		return 0;
+	return blockSize_ - (back.data_ + back.len_ - back.block_);
+}
+
+void MsgBufferChain::appendBlock()
+{
+	std::shared_ptr<char> block;
+	if (spareBlock_)
+	{
+		block.swap(spareBlock_);
+	}
+	else
+	{
+		block = std::shared_ptr<char>(new char[blockSize_],
+			std::default_delete<char[]>());
+	}
+	Slice slice;
+	slice.data_ = block.get();
+	slice.len_ = 0;
+	slice.block_ = block.get();
+	slice.owner_ = std::move(block);
+	slices_.push_back(std::move(slice));
+}
+
+void MsgBufferChain::append(const char* buf, size_t len)
+{
+	readableBytes_ += len;
+	while (len > 0)
+	{
+		size_t writable = writableBytesInBack();
+		if (writable == 0)
+		{
+			appendBlock();
+			writable = blockSize_;
+		}
+		auto& back = slices_.back();
+		size_t n = len < writable ? len : writable;
+		memcpy(const_cast<char*>(back.data_) + back.len_, buf, n);
+		back.len_ += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+void MsgBufferChain::append(MsgBuffer&& buf)
+{
+	if (buf.readableBytes() == 0)
+		return;
+	auto holder = std::make_shared<MsgBuffer>(std::move(buf));
+	const char* data = holder->peek();
+	size_t len = holder->readableBytes();
+	appendExternal(data, len, std::move(holder));
+}
+
+void MsgBufferChain::appendExternal(const char* data,
+	size_t len,
+	std::shared_ptr<void> owner)
+{
+	if (len == 0)
+		return;
+	Slice slice;
+	slice.data_ = data;
+	slice.len_ = len;
+	slice.block_ = nullptr;
+	slice.owner_ = std::move(owner);
+	slices_.push_back(std::move(slice));
+	readableBytes_ += len;
+}
+
+size_t MsgBufferChain::peekIovecs(struct iovec* vecs, size_t maxVecs) const
+{
+	size_t n = 0;
+	for (auto iter = slices_.begin(); iter != slices_.end() && n < maxVecs;
+		++iter)
+	{
+		if (iter->len_ == 0)
+			continue;
+		vecs[n].iov_base = const_cast<char*>(iter->data_);
+		vecs[n].iov_len = static_cast<decltype(vecs[n].iov_len)>(iter->len_);
+		++n;
+	}
+	return n;
+}
+
+ssize_t MsgBufferChain::writeFd(int fd, int* retErrno)
+{
+	struct iovec vecs[xMaxIovecs];
+	size_t iovcnt = peekIovecs(vecs, xMaxIovecs);
+	if (iovcnt == 0)
+		return 0;
+	ssize_t n = ::writev(fd, vecs, static_cast<int>(iovcnt));
+	if (n < 0)
+	{
+		*retErrno = errno;
+	}
+	else
+	{
+		retrieve(static_cast<size_t>(n));
+	}
+	return n;
+}
+
+void MsgBufferChain::retrieve(size_t len)
+{
+	if (len >= readableBytes_)
+	{
+		retrieveAll();
+		return;
+	}
+	readableBytes_ -= len;
+	while (len > 0)
+	{
+		auto& front = slices_.front();
+		if (front.len_ > len)
+		{
+			front.data_ += len;
+			front.len_ -= len;
+			return;
+		}
+		len -= front.len_;
+		if (front.block_ && !spareBlock_ && front.owner_.use_count() == 1)
+		{
+			spareBlock_ =
+				std::static_pointer_cast<char>(std::move(front.owner_));
+		}
+		slices_.pop_front();
+	}
+}
+
+void MsgBufferChain::retrieveAll()
+{
+	while (!slices_.empty())
+	{
+		auto& front = slices_.front();
+		if (front.block_ && !spareBlock_ && front.owner_.use_count() == 1)
+		{
+			spareBlock_ =
+				std::static_pointer_cast<char>(std::move(front.owner_));
+		}
+		slices_.pop_front();
+	}
+	readableBytes_ = 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file   MsgBufferChain.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/utils/MsgBuffer.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <assert.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#else
+#include <xiao/utils/WindowsSupport.h>
+#endif
+
+BEGIN_NAMESPACE(xiao)
+
+static constexpr size_t xChainBlockSize{ 16 * 1024 };
+
+/**
+ * @brief This class represents a send buffer made of a chain of slices. Data
+ * appended by copy goes into fixed-size blocks, and a new block is chained
+ * when the last one is full, so the data already in the buffer is never
+ * moved. Externally owned memory (e.g. an mmap'ed file region) can be
+ * spliced into the chain without copying. The readable data is handed out as
+ * an iovec array for writev.
+ */
+class XIAO_EXPORT MsgBufferChain : NonCopyable
+{
+public:
+	explicit MsgBufferChain(size_t blockSize = xChainBlockSize);
+
+	size_t readableBytes() const
+	{
+		return readableBytes_;
+	}
+
+	bool empty() const
+	{
+		return readableBytes_ == 0;
+	}
+
+	/**
+	 * @brief Return the number of slices in the chain.
+	 */
+	size_t sliceCount() const
+	{
+		return slices_.size();
+	}
+
+	/**
+	 * @brief Copy data to the end of the chain.
+	 *
+	 * \param buf
+	 * \param len
+	 */
+	void append(const char* buf, size_t len);
+	void append(const std::string& buf)
+	{
+		append(buf.c_str(), buf.length());
+	}
+	void append(const MsgBuffer& buf)
+	{
+		append(buf.peek(), buf.readableBytes());
+	}
+	template <int N>
+	void append(const char(&buf)[N])
+	{
+		assert(strnlen(buf, N) == N - 1);
+		append(buf, N - 1);
+	}
+
+	/**
+	 * @brief Splice a MsgBuffer into the chain without copying its data. The
+	 * chain takes the ownership of the buffer.
+	 */
+	void append(MsgBuffer&& buf);
+
+	/**
+	 * @brief Splice externally owned memory into the chain without copying.
+	 *
+	 * \param data The beginning of the memory.
+	 * \param len The length of the memory.
+	 * \param owner The owner of the memory, it is released after the slice
+	 * has been retrieved. The memory must stay valid and unchanged while the
+	 * owner is alive.
+	 */
+	void appendExternal(const char* data,
+		size_t len,
+		std::shared_ptr<void> owner);
+
+	/**
+	 * @brief Fill the iovec array with the readable slices.
+	 *
+	 * \param vecs The iovec array.
+	 * \param maxVecs The size of the iovec array.
+	 * \return The number of iovecs filled.
+	 */
+	size_t peekIovecs(struct iovec* vecs, size_t maxVecs) const;
+
+	/**
+	 * @brief Write the readable data to the fd with writev, and retrieve the
+	 * bytes written.
+	 *
+	 * \param fd
+	 * \param retErrno The errno is stored here when writev fails.
+	 * \return The return value of writev.
+	 */
+	ssize_t writeFd(int fd, int* retErrno);
+
+	void retrieve(size_t len);
+
+	void retrieveAll();
+
+private:
+	struct Slice
+	{
+		const char* data_;
+		size_t len_;
+		// the whole block if the slice is owned by the chain, nullptr for
+		// external slices.
+		char* block_;
+		std::shared_ptr<void> owner_;
+	};
+
+	size_t writableBytesInBack() const;
+	void appendBlock();
+
+	size_t blockSize_;
+	size_t readableBytes_{ 0 };
+	std::deque<Slice> slices_;
+	// one spare block, so that a steady stream of appends and retrieves does
+	// not allocate.
+	std::shared_ptr<char> spareBlock_;
+};
+
+END_NAMESPACE(xiao)
@@ -8,9 +8,12 @@
 #pragma once
 
 #include "NonCopyable.h"
+#include "InlineTask.h"
+#include "Future.h"
 #include <functional>
 #include <string>
 #include <future>
+#include <memory>
 
 BEGIN_NAMESPACE(xiao)
 
@@ -19,6 +22,36 @@ class TaskQueue : public NonCopyable
 public:
 	virtual void runTaskInQueue(const std::function<void()>& task) = 0;
 	virtual void runTaskInQueue(std::function<void()>&& task) = 0;
+
+	/**
+	 * @brief Run a move-only task in the queue. Queues that store SmallTask
+	 * natively override this method to avoid allocating per task, the default
+	 * implementation wraps the task into a std::function.
+	 */
+	virtual void runTaskInQueue(SmallTask&& task)
+	{
+		auto taskPtr = std::make_shared<SmallTask>(std::move(task));
+		runTaskInQueue([taskPtr]() { (*taskPtr)(); });
+	}
+
+	/**
+	 * @brief Run a task in the queue and return a future of its result. The
+	 * future doesn't block any thread, continuations can be attached with
+	 * Future::then().
+	 */
+	template <typename F>
+	auto submit(F&& f) -> Future<decltype(f())>
+	{
+		using R = decltype(f());
+		Promise<R> promise;
+		auto future = promise.getFuture();
+		runTaskInQueue(SmallTask([promise = std::move(promise),
+								  f = std::forward<F>(f)]() mutable {
+			internal::Fulfill<R>::run(promise, f);
+		}));
+		return future;
+	}
+
 	virtual std::string getName() const
 	{
 		return "";
@@ -0,0 +1,100 @@
+/**
+ * @file   TimingWheel.h
+ * @author xiao guo
+ *
+ *
+ * @date   2026-10-17
+ */
+#pragma once
+
+#include <xiao/utils/NonCopyable.h>
+#include <xiao/net/EventLoop.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+BEGIN_NAMESPACE(xiao)
+
+using EntryPtr = std::shared_ptr<void>;
+using EntryBucket = std::unordered_set<EntryPtr>;
+using BucketQueue = std::deque<EntryBucket>;
+
+/**
+ * @brief This class implements a hierarchical timer wheel for kicking out
+ * idle connections. Inserting or refreshing an entry is O(1): the entry is
+ * put into one bucket of the lowest wheel that can hold its delay. When a
+ * bucket of a higher wheel expires, its entries cascade down to the lower
+ * wheels. An entry times out when the last reference to it is dropped from
+ * the buckets, so refreshing is just inserting the same entry again.
+ */
+class XIAO_EXPORT TimingWheel
+{
+public:
+	class CallbackEntry
+	{
+	public:
+		CallbackEntry(std::function<void()> cb) : cb_(std::move(cb))
+		{
+		}
+		~CallbackEntry()
+		{
+			cb_();
+		}
+
+	private:
+		std::function<void()> cb_;
+	};
+
+	/**
+	 * @brief Construct a new timing wheel instance.
+	 *
+	 * \param loop The event loop in which the timing wheel runs.
+	 * \param maxTimeout The maximum timeout of the timing wheel.
+	 * \param ticksInterval The internal timer tick interval. It affects the
+	 * accuracy of the timing wheel.
+	 * \param bucketsNumPerWheel The number of buckets per wheel.
+	 * \note The max delay of the timing wheel is about
+	 * ticksInterval*(bucketsNumPerWheel^wheelsNum), the wheelsNum is computed
+	 * from maxTimeout.
+	 */
+	TimingWheel(EventLoop* loop,
+		size_t maxTimeout,
+		float ticksInterval = 1.0,
+		size_t bucketsNumPerWheel = 100);
+
+	/**
+	 * @brief Insert an entry into the timing wheel.
+	 *
+	 * \param delay The timeout of the entry in seconds.
+	 * \param entryPtr The shared pointer of the entry. When it's released by
+	 * the timing wheel and nobody else holds it, the entry times out.
+	 * \note This method can be called in any thread.
+	 */
+	void insertEntry(size_t delay, EntryPtr entryPtr);
+
+	void insertEntryInloop(size_t delay, EntryPtr entryPtr);
+
+	EventLoop* getLoop()
+	{
+		return loop_;
+	}
+
+	~TimingWheel();
+
+private:
+	std::vector<BucketQueue> wheels_;
+
+	std::atomic<size_t> ticksCounter_{ 0 };
+
+	TimerId timerId_;
+	EventLoop* loop_;
+
+	float ticksInterval_;
+	size_t wheelsNum_;
+	size_t bucketsNumPerWheel_;
+};
+
+END_NAMESPACE(xiao)
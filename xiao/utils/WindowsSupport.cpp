@@ -19,6 +19,16 @@ int win32_read_socket(int fd, void* buf, int n)
 	return rc;
 }
 
+int win32_write_socket(int fd, const void* buf, int n)
+{
+	int rc = send(fd, reinterpret_cast<const char*>(buf), n, 0);
+	if (rc == SOCKET_ERROR)
+	{
+		_set_errno(WSAGetLastError());
+	}
+	return rc;
+}
+
 int readv(int fd, const struct iovec* vector, int count)
 {
 	int ret = 0;
@@ -46,3 +56,31 @@ int readv(int fd, const struct iovec* vector, int count)
 	}
 	return ret;
 }
+
+int writev(int fd, const struct iovec* vector, int count)
+{
+	int ret = 0;
+	int i;
+	for (i = 0; i < count; i++)
+	{
+		int n = vector[i].iov_len;
+		int rc = win32_write_socket(fd, vector[i].iov_base, n);
+		if (rc == n)
+		{
+			ret += rc;
+		}
+		else
+		{
+			if (rc < 0)
+			{
+				ret = (ret == 0 ? rc : ret);
+			}
+			else
+			{
+				ret += rc;
+			}
+			break;
+		}
+	}
+	return ret;
+}
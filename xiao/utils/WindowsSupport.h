@@ -16,3 +16,4 @@ struct iovec
 };
 
 XIAO_EXPORT int readv(int fd, const struct iovec* vector, int count);
+XIAO_EXPORT int writev(int fd, const struct iovec* vector, int count);